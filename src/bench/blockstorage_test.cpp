@@ -0,0 +1,123 @@
+// checks the palette storage of the chunk sections against a plain array of blocks, exits with 1 on failure
+// build from src/: g++ -O2 -std=c++17 -Iinclude bench/blockstorage_test.cpp blockstorage.cpp -o blockstorage_test
+// usage: blockstorage_test [seed]
+
+#include "blockstorage.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+static int n_failed = 0;
+
+static void check(bool ok, const char *test, const char *what) {
+	if (!ok) {
+		printf("FAIL %s: %s\n", test, what);
+		n_failed++;
+	}
+}
+
+// every block, single and by rows, must be the one of the reference
+static bool sameBlocks(const BlockStorage *storage, const Block *expected) {
+	Block row[STORAGE_SIZE];
+	storage->getRow(0, STORAGE_SIZE, row);
+	for (int i = 0; i < STORAGE_SIZE; i++) {
+		if (storage->get(i) != expected[i] || row[i] != expected[i]) {
+			return false;
+		}
+	}
+	// rows that don't start on an index word
+	storage->getRow(37, 1000, row);
+	for (int i = 0; i < 1000; i++) {
+		if (row[i] != expected[37 + i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// smallest index size for a number of block types
+static int getExpectedBits(int n_types) {
+	if (n_types <= 1) return 0;
+	if (n_types <= 2) return 1;
+	if (n_types <= 4) return 2;
+	if (n_types <= PALETTE_MAX_SIZE) return 4;
+	return 8;
+}
+
+int main(int argc, char *argv[]) {
+
+	unsigned int seed = argc > 1 ? atoi(argv[1]) : 1;
+	srand(seed);
+
+	BlockStorage storage;
+	Block expected[STORAGE_SIZE];
+
+	// a new storage is all air, without indices
+	for (int i = 0; i < STORAGE_SIZE; i++) {
+		expected[i] = BlockType::AIR;
+	}
+	check(sameBlocks(&storage, expected) && storage.getBits() == 0, "empty", "not a single air block");
+
+	// set returns the previous block, the index size grows with the number of types
+	for (int n_types = 2; n_types <= 40; n_types += 1) {
+		for (int k = 0; k < 3000; k++) {
+			int i = rand() % STORAGE_SIZE;
+			Block block = rand() % n_types;
+			Block previous = storage.set(i, block);
+			if (previous != expected[i]) {
+				check(false, "set", "wrong previous block");
+				break;
+			}
+			expected[i] = block;
+		}
+		check(sameBlocks(&storage, expected), "set", "blocks differ from the reference");
+	}
+	check(storage.getBits() == 8, "set", "more than PALETTE_MAX_SIZE types are not stored directly");
+
+	// compact and fill pick the smallest index size for the types left
+	int typeCounts[] = { 1, 2, 3, 4, 5, 16, 17, 255 };
+	for (int t = 0; t < (int)(sizeof(typeCounts) / sizeof(typeCounts[0])); t++) {
+		int n_types = typeCounts[t];
+		Block base = rand() % 200;
+		for (int i = 0; i < STORAGE_SIZE; i++) {
+			// every type is used at least once
+			Block block = (i < n_types) ? i : rand() % n_types;
+			storage.set(i, (Block)(base + block));
+			expected[i] = (Block)(base + block);
+		}
+		storage.compact();
+		check(sameBlocks(&storage, expected), "compact", "blocks changed");
+		check(storage.getBits() == getExpectedBits(n_types), "compact", "index size is not the smallest");
+
+		BlockStorage filled;
+		filled.fill(expected);
+		check(sameBlocks(&filled, expected), "fill", "blocks differ from the source");
+		check(filled.getBits() == getExpectedBits(n_types), "fill", "index size is not the smallest");
+	}
+
+	// a type whose last block is removed frees its palette entry for the next one
+	storage.reset(BlockType::STONE);
+	for (int i = 0; i < STORAGE_SIZE; i++) {
+		expected[i] = BlockType::STONE;
+	}
+	for (int k = 0; k < 100000; k++) {
+		int i = rand() % 64;
+		Block block = BlockType::STONE + rand() % 4 + (k / 1000) % 40; // 43 types, only a few at once
+		storage.set(i, block);
+		expected[i] = block;
+	}
+	check(sameBlocks(&storage, expected), "reuse", "blocks differ from the reference");
+	check(storage.getBits() <= 4, "reuse", "palette entries are not reused");
+
+	// reset frees the indices
+	storage.reset(BlockType::DIRT);
+	for (int i = 0; i < STORAGE_SIZE; i++) {
+		expected[i] = BlockType::DIRT;
+	}
+	check(sameBlocks(&storage, expected) && storage.getBits() == 0 && storage.getDataSize() == 0, "reset", "not a single block");
+
+	if (n_failed == 0) {
+		printf("blockstorage_test: ok\n");
+	}
+	return n_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+// checks that greedy meshing draws exactly the faces of naive meshing, exits with 1 on failure
+// every greedy quad is cut back into block faces, with its texture and the ambient occlusion interpolated
+// at their corners: they must be the faces of the naive mesh, and the texture must repeat once per block
+// build from src/: g++ -O2 -std=c++17 -Iinclude -IFastNoise2/include bench/meshing_test.cpp meshbuilder.cpp blockstorage.cpp profiler.cpp -o meshing_test
+// usage: meshing_test [seeds]
+
+#include "chunk.h"
+#include "meshbuilder.h"
+#include "profiler.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+// axes of each face (u, v: face plane, n: normal), same order as the faces
+/* order: back, front, left, right, bottom, top */
+static const int faceAxes[6][3] = {
+	{ 0, 1, 2 },
+	{ 0, 1, 2 },
+	{ 2, 1, 0 },
+	{ 2, 1, 0 },
+	{ 0, 2, 1 },
+	{ 0, 2, 1 }
+};
+
+// a quad read back from the packed vertices
+struct TestQuad {
+	int face;
+	int tile;
+	int pos[4][3]; // block corners (vertex position + 0.5)
+	int uv[4][2];
+	int ao[4];
+};
+
+static int n_failed = 0;
+
+static void check(bool ok, const char *test, const char *what) {
+	if (!ok) {
+		printf("FAIL %s: %s\n", test, what);
+		n_failed++;
+	}
+}
+
+// unpacks the vertices (see CHUNK_VERTEX_SIZE), 4 per quad
+static std::vector<TestQuad> readQuads(const unsigned int *data, int n_vertices) {
+	std::vector<TestQuad> quads(n_vertices / 4);
+	for (int i = 0; i < quads.size(); i++) {
+		for (int k = 0; k < 4; k++) {
+			unsigned int a = data[(i * 4 + k) * CHUNK_VERTEX_SIZE];
+			unsigned int b = data[(i * 4 + k) * CHUNK_VERTEX_SIZE + 1];
+			quads[i].pos[k][0] = a & 31;
+			quads[i].pos[k][1] = (a >> 5) & 511;
+			quads[i].pos[k][2] = (a >> 14) & 31;
+			quads[i].face = (a >> 19) & 7;
+			quads[i].ao[k] = (a >> 22) & 3;
+			quads[i].uv[k][0] = b & 511;
+			quads[i].uv[k][1] = (b >> 9) & 511;
+			quads[i].tile = (b >> 18) & 63;
+		}
+	}
+	return quads;
+}
+
+// index of a quad's corner from its sides: 1 on the far u side, 2 on the far v side
+static int getCorner(const TestQuad *quad, int k, int minU, int minV) {
+	int u = faceAxes[quad->face][0];
+	int v = faceAxes[quad->face][1];
+	return (quad->pos[k][u] > minU ? 1 : 0) + (quad->pos[k][v] > minV ? 2 : 0);
+}
+
+// ambient occlusion of the quad interpolated at a block corner (du, dv from the quad's first corner),
+// AO_NONE if it falls between two levels (a gradient stretched over several blocks)
+#define AO_NONE 7
+static int interpolateAO(const int ao[4], int du, int dv, int width, int height) {
+	int sum = ao[0] * (width - du) * (height - dv) + ao[1] * du * (height - dv)
+		+ ao[2] * (width - du) * dv + ao[3] * du * dv;
+	return sum % (width * height) == 0 ? sum / (width * height) : AO_NONE;
+}
+
+// cuts the quads into block faces: face, plane, u, v, texture and ambient occlusion of each corner
+// cross meshes (never merged) are kept whole
+// uvStep receives the uv change of one block along u and v for each face (naive mesh), returns 0 if a quad
+// doesn't repeat its texture once per block
+static int getBlockFaces(const std::vector<TestQuad> &quads, std::vector<uint64_t> *faces, int uvStep[6][2][2], bool learnSteps) {
+
+	int ok = 1;
+	for (int i = 0; i < quads.size(); i++) {
+		const TestQuad *quad = &quads[i];
+
+		if (quad->face == FACE_CROSS) {
+			// hash of the vertices, the top bit keeps them apart from the block faces
+			uint64_t key = 1469598103934665603ull;
+			for (int k = 0; k < 4; k++) {
+				key = (key ^ (quad->pos[k][0] | quad->pos[k][1] << 5 | quad->pos[k][2] << 14 | quad->uv[k][0] << 23 | quad->uv[k][1] << 25 | quad->tile << 26)) * 1099511628211ull;
+			}
+			faces->push_back(key | (1ull << 63));
+			continue;
+		}
+
+		int u = faceAxes[quad->face][0];
+		int v = faceAxes[quad->face][1];
+		int n = faceAxes[quad->face][2];
+		int minU = 1 << 20, maxU = 0, minV = 1 << 20, maxV = 0;
+		for (int k = 0; k < 4; k++) {
+			minU = std::min(minU, quad->pos[k][u]);
+			maxU = std::max(maxU, quad->pos[k][u]);
+			minV = std::min(minV, quad->pos[k][v]);
+			maxV = std::max(maxV, quad->pos[k][v]);
+		}
+
+		int ao[4];
+		int uv[4][2];
+		for (int k = 0; k < 4; k++) {
+			int corner = getCorner(quad, k, minU, minV);
+			ao[corner] = quad->ao[k];
+			uv[corner][0] = quad->uv[k][0];
+			uv[corner][1] = quad->uv[k][1];
+		}
+
+		// the uv change along u and v is the one of a single face times the quad size
+		int width = maxU - minU;
+		int height = maxV - minV;
+		for (int c = 0; c < 2; c++) {
+			int du = uv[1][c] - uv[0][c];
+			int dv = uv[2][c] - uv[0][c];
+			if (learnSteps) {
+				uvStep[quad->face][0][c] = du;
+				uvStep[quad->face][1][c] = dv;
+			}
+			else if (du != uvStep[quad->face][0][c] * width || dv != uvStep[quad->face][1][c] * height) {
+				ok = 0;
+			}
+		}
+
+		uint64_t key = (uint64_t)quad->face << 45 | (uint64_t)quad->pos[0][n] << 36 | (uint64_t)quad->tile << 12;
+		for (int a = minU; a < maxU; a++) {
+			for (int b = minV; b < maxV; b++) {
+				uint64_t blockAO = 0;
+				for (int corner = 0; corner < 4; corner++) {
+					int du = a - minU + (corner & 1);
+					int dv = b - minV + (corner >> 1);
+					blockAO |= interpolateAO(ao, du, dv, width, height) << (corner * 3);
+				}
+				faces->push_back(key | (uint64_t)a << 27 | (uint64_t)b << 18 | blockAO);
+			}
+		}
+	}
+	return ok;
+}
+
+// terrain with caves, trees (leaves over logs), herbs (cross meshes) and scattered blocks
+static void fillTestChunk(Chunk *chunk, unsigned int seed) {
+
+	unsigned int h = seed * 0x9E3779B1u ^ (chunk->position.x * 0x85EBCA77u) ^ (chunk->position.y * 0xC2B2AE3Du);
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			int height = 40 + (x * 3 + z * 5 + seed) % 7 + (x > 8 ? 4 : 0);
+			for (int y = 0; y < height; y++) {
+				h = h * 1664525u + 1013904223u;
+				// holes inside the ground (varied ambient occlusion)
+				if (y > 20 && y < height - 3 && (h >> 24) < 30) {
+					continue;
+				}
+				chunk->setBlock(x, y, z, y < height - 4 ? BlockType::STONE : (y < height - 1 ? BlockType::DIRT : BlockType::GRASS));
+			}
+			h = h * 1664525u + 1013904223u;
+			if ((h >> 24) < 20) {
+				chunk->setBlock(x, height, z, BlockType::HERB);
+			}
+			else if ((h >> 24) < 24 && height + 8 < HEIGHT_LIMIT) {
+				for (int y = height; y < height + 5; y++) {
+					chunk->setBlock(x, y, z, BlockType::LOG);
+				}
+				for (int dx = -2; dx <= 2; dx++) {
+					for (int dz = -2; dz <= 2; dz++) {
+						for (int y = height + 3; y < height + 7; y++) {
+							if (x + dx >= 0 && x + dx < CHUNK_SIZE && z + dz >= 0 && z + dz < CHUNK_SIZE && chunk->getBlock(x + dx, y, z + dz) == BlockType::AIR) {
+								chunk->setBlock(x + dx, y, z + dz, BlockType::LEAVES);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// floating blocks up to the top of the world
+	for (int i = 0; i < 200; i++) {
+		h = h * 1664525u + 1013904223u;
+		chunk->setBlock(h % CHUNK_SIZE, (h >> 8) % HEIGHT_LIMIT, (h >> 16) % CHUNK_SIZE, static_cast<BlockType>(1 + (h >> 24) % 12));
+	}
+
+	chunk->compactSections();
+	chunk->calculateHeightmap();
+}
+
+int main(int argc, char *argv[]) {
+
+	int n_seeds = argc > 1 ? atoi(argv[1]) : 4;
+	Profiler::enabled = false;
+
+	// 3 x 3 chunks: the one in the middle is meshed, the others give it its borders
+	Chunk *chunks = new Chunk[9];
+	Chunk *center = &chunks[4];
+	MeshBuilder builder;
+	long long n_naive = 0, n_greedy = 0;
+
+	for (int seed = 0; seed < n_seeds; seed++) {
+		for (int i = 0; i < 9; i++) {
+			chunks[i].resetBlockData();
+			chunks[i].position = glm::ivec2(i % 3 + seed * 3, i / 3);
+			fillTestChunk(&chunks[i], seed);
+		}
+		center->neighbors[NEIGHBOR_LEFT] = &chunks[3];
+		center->neighbors[NEIGHBOR_RIGHT] = &chunks[5];
+		center->neighbors[NEIGHBOR_DOWN] = &chunks[1];
+		center->neighbors[NEIGHBOR_UP] = &chunks[7];
+
+		ChunkSnapshot *snapshot = builder.getSnapshot();
+		std::vector<TestQuad> naive[N_SECTIONS];
+		std::vector<TestQuad> greedy[N_SECTIONS];
+		for (int mode = 0; mode < 2; mode++) {
+			Chunk::meshingMode = mode == 0 ? MESHING_NAIVE : MESHING_GREEDY;
+			center->takeSnapshot(snapshot, ALL_SECTIONS);
+			const ChunkMesh *mesh = builder.build(snapshot);
+			for (int s = 0; s < N_SECTIONS; s++) {
+				(mode == 0 ? naive : greedy)[s] = readQuads(mesh->getSection(s), mesh->getSectionVertices(s));
+			}
+		}
+
+		int uvStep[6][2][2] = {};
+		for (int s = 0; s < N_SECTIONS; s++) {
+			std::vector<uint64_t> naiveFaces, greedyFaces;
+			getBlockFaces(naive[s], &naiveFaces, uvStep, true);
+			int uvOk = getBlockFaces(greedy[s], &greedyFaces, uvStep, false);
+			std::sort(naiveFaces.begin(), naiveFaces.end());
+			std::sort(greedyFaces.begin(), greedyFaces.end());
+
+			check(naiveFaces == greedyFaces, "greedy", "block faces differ from the naive mesh");
+			check(uvOk, "greedy", "texture not repeated once per block");
+			check(greedy[s].size() <= naive[s].size(), "greedy", "more quads than the naive mesh");
+			n_naive += naive[s].size();
+			n_greedy += greedy[s].size();
+		}
+	}
+
+	delete[] chunks;
+
+	printf("naive %lld quads, greedy %lld quads\n", n_naive, n_greedy);
+	if (n_failed == 0) {
+		printf("meshing_test: ok\n");
+	}
+	return n_failed == 0 ? 0 : 1;
+}
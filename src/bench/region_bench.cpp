@@ -0,0 +1,131 @@
+// region file save/load throughput, in chunks per second
+// build from src/: g++ -O2 -std=c++17 -Iinclude -IFastNoise2/include bench/region_bench.cpp region.cpp mappedfile.cpp blockstorage.cpp -o region_bench
+// usage: region_bench [chunks per side] [directory]
+
+#include "region.h"
+#include "chunk.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+static double getSeconds() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// terrain-like chunk: stone, dirt and grass up to a varying height, with a few scattered blocks (player edits, trees)
+static void fillBenchChunk(Chunk *chunk) {
+
+	unsigned int h = static_cast<unsigned int>(chunk->position.x) * 0x9E3779B1u ^ static_cast<unsigned int>(chunk->position.y) * 0x85EBCA77u;
+
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			int height = 30 + (x + z + static_cast<int>(h % 7)) % 12;
+			for (int y = 0; y < height - 4; y++) {
+				chunk->setBlock(x, y, z, BlockType::STONE);
+			}
+			for (int y = height - 4; y < height - 1; y++) {
+				chunk->setBlock(x, y, z, BlockType::DIRT);
+			}
+			chunk->setBlock(x, height - 1, z, BlockType::GRASS);
+		}
+	}
+
+	for (int i = 0; i < 64; i++) {
+		h = h * 1664525u + 1013904223u;
+		chunk->setBlock(h % CHUNK_SIZE, 20 + (h >> 8) % 40, (h >> 16) % CHUNK_SIZE, static_cast<BlockType>(1 + (h >> 24) % 8));
+	}
+
+	chunk->compactSections();
+}
+
+static int sameBlocks(Chunk *a, Chunk *b) {
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		for (int y = 0; y < HEIGHT_LIMIT; y++) {
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				if (a->getBlock(x, y, z) != b->getBlock(x, y, z)) {
+					return 0;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+int main(int argc, char **argv) {
+
+	int side = argc > 1 ? atoi(argv[1]) : 64; // chunks per side (spread over several region files)
+	const char *directory = argc > 2 ? argv[2] : "region_bench_world";
+	int n_chunks = side * side;
+
+	std::filesystem::remove_all(directory);
+
+	Chunk *chunks = new Chunk[n_chunks];
+	for (int i = 0; i < n_chunks; i++) {
+		chunks[i].position = glm::ivec2(i % side - side / 2, i / side - side / 2);
+		fillBenchChunk(&chunks[i]);
+	}
+
+	long long dataSize = 0;
+	double saveTime, flushTime, loadTime;
+	{
+		RegionStore store;
+		store.init(directory);
+
+		// saving: compression into the pending list
+		double start = getSeconds();
+		for (int i = 0; i < n_chunks; i++) {
+			store.saveChunk(&chunks[i]);
+		}
+		saveTime = getSeconds() - start;
+
+		// writing to the region files (synced)
+		start = getSeconds();
+		store.flush();
+		flushTime = getSeconds() - start;
+	}
+
+	for (auto& entry : std::filesystem::directory_iterator(directory)) {
+		dataSize += entry.file_size();
+	}
+
+	// loading from freshly opened region files
+	int errors = 0;
+	{
+		RegionStore store;
+		store.init(directory);
+
+		Chunk *loaded = new Chunk;
+		double start = getSeconds();
+		for (int i = 0; i < n_chunks; i++) {
+			loaded->resetBlockData();
+			loaded->position = chunks[i].position;
+			if (!store.loadChunk(loaded)) {
+				errors++;
+			}
+		}
+		loadTime = getSeconds() - start;
+		store.printLoadStats();
+
+		// check the round trip outside of the timed loop
+		for (int i = 0; i < n_chunks; i++) {
+			loaded->resetBlockData();
+			loaded->position = chunks[i].position;
+			if (!store.loadChunk(loaded) || !sameBlocks(loaded, &chunks[i])) {
+				errors++;
+			}
+		}
+		delete loaded;
+	}
+
+	std::cout << n_chunks << " chunks | "
+		<< dataSize / 1024 << " KB on disk (" << dataSize / n_chunks << " B/chunk) | "
+		<< "save " << n_chunks / saveTime << " chunks/s | "
+		<< "write " << n_chunks / flushTime << " chunks/s | "
+		<< "load " << n_chunks / loadTime << " chunks/s"
+		<< (errors ? " | ROUND TRIP ERRORS: " : "") << (errors ? std::to_string(errors) : "") << "\n";
+
+	delete[] chunks;
+	std::filesystem::remove_all(directory);
+	return errors != 0;
+}
@@ -0,0 +1,190 @@
+// checks that chunks come back unchanged from the RLE encoding and from the region files, exits with 1 on failure
+// build from src/: g++ -O2 -std=c++17 -Iinclude -IFastNoise2/include bench/region_test.cpp region.cpp mappedfile.cpp blockstorage.cpp -o region_test
+// usage: region_test [directory]
+
+#include "region.h"
+#include "chunk.h"
+
+#include <cstdio>
+#include <filesystem>
+
+static int n_failed = 0;
+
+static void check(bool ok, const char *test, const char *what) {
+	if (!ok) {
+		printf("FAIL %s: %s\n", test, what);
+		n_failed++;
+	}
+}
+
+// chunk contents the encoding must handle
+enum TestPattern {
+	PATTERN_EMPTY,
+	PATTERN_FULL, // a single block type everywhere
+	PATTERN_TERRAIN, // layers and a few scattered blocks (long runs)
+	PATTERN_NOISE, // a different block almost every time (runs of 1, the worst case)
+	PATTERN_TOP, // a single block at the top of the world
+	N_PATTERNS
+};
+
+static void fillTestChunk(Chunk *chunk, int pattern, unsigned int seed) {
+
+	unsigned int h = seed * 0x9E3779B1u + 1;
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			for (int y = 0; y < HEIGHT_LIMIT; y++) {
+				h = h * 1664525u + 1013904223u;
+				BlockType type = BlockType::AIR;
+				switch (pattern) {
+				case PATTERN_FULL:
+					type = BlockType::STONE;
+					break;
+				case PATTERN_TERRAIN:
+					if (y < 30 + (x + z) % 12) {
+						type = y < 26 ? BlockType::STONE : BlockType::DIRT;
+					}
+					if ((h >> 24) < 2) {
+						type = static_cast<BlockType>(1 + (h >> 8) % 14);
+					}
+					break;
+				case PATTERN_NOISE:
+					type = static_cast<BlockType>((h >> 16) % 15);
+					break;
+				case PATTERN_TOP:
+					if (x == 3 && z == 5 && y == HEIGHT_LIMIT - 1) {
+						type = BlockType::LOG;
+					}
+					break;
+				}
+				if (type != BlockType::AIR) {
+					chunk->setBlock(x, y, z, type);
+				}
+			}
+		}
+	}
+	chunk->compactSections();
+}
+
+static bool sameChunk(Chunk *a, Chunk *b) {
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			if (a->getHeight(x, z) != b->getHeight(x, z)) {
+				return false;
+			}
+			for (int y = 0; y < HEIGHT_LIMIT; y++) {
+				if (a->getBlock(x, y, z) != b->getBlock(x, y, z)) {
+					return false;
+				}
+			}
+		}
+	}
+	return a->maxHeight == b->maxHeight;
+}
+
+static void testEncoding(Chunk *chunk, Chunk *decoded) {
+
+	std::vector<unsigned char> data;
+	for (int pattern = 0; pattern < N_PATTERNS; pattern++) {
+		chunk->resetBlockData();
+		fillTestChunk(chunk, pattern, pattern);
+		chunk->calculateHeightmap();
+
+		encodeChunk(chunk, &data);
+		decoded->resetBlockData();
+		bool ok = decodeChunk(data.data(), static_cast<int>(data.size()), decoded) && sameChunk(chunk, decoded);
+		check(ok, "encoding", "decoded chunk differs");
+	}
+
+	// damaged data is refused, not decoded into a partial chunk
+	chunk->resetBlockData();
+	fillTestChunk(chunk, PATTERN_TERRAIN, 7);
+	encodeChunk(chunk, &data);
+
+	check(!decodeChunk(data.data(), static_cast<int>(data.size()) - 2, decoded), "encoding", "truncated data accepted");
+
+	std::vector<unsigned char> wrong = data;
+	wrong[0]++;
+	check(!decodeChunk(wrong.data(), static_cast<int>(wrong.size()), decoded), "encoding", "other format version accepted");
+
+	wrong = data;
+	wrong.push_back(1);
+	wrong.push_back(BlockType::STONE);
+	check(!decodeChunk(wrong.data(), static_cast<int>(wrong.size()), decoded), "encoding", "data past the last section accepted");
+
+	// the last byte is the block type of the last run
+	wrong = data;
+	wrong.back() = BlockType::MOON + 1;
+	check(!decodeChunk(wrong.data(), static_cast<int>(wrong.size()), decoded), "encoding", "unknown block type accepted");
+}
+
+static void testRegions(const char *directory, Chunk *chunk, Chunk *loaded) {
+
+	std::filesystem::remove_all(directory);
+
+	// around the origin: 4 region files, with negative coordinates
+	const int side = 2 * REGION_SIZE;
+	auto getPattern = [](int i, int version) { return (i + version) % N_PATTERNS; };
+
+	for (int version = 0; version < 2; version++) {
+		{
+			RegionStore store;
+			store.init(directory);
+			for (int i = 0; i < side * side; i += 3) {
+				chunk->resetBlockData();
+				chunk->position = glm::ivec2(i % side - side / 2, i / side - side / 2);
+				fillTestChunk(chunk, getPattern(i, version), i);
+				store.saveChunk(chunk);
+			}
+
+			// readable before the flush, from the pending list
+			loaded->resetBlockData();
+			loaded->position = chunk->position;
+			check(store.loadChunk(loaded) && sameChunk(chunk, loaded), "regions", "pending chunk differs");
+
+			// the second version replaces every chunk (with other sizes)
+			store.flush();
+			check(!store.hasPendingChunks(), "regions", "chunks left pending after the flush");
+		}
+
+		// freshly opened region files
+		RegionStore store;
+		store.init(directory);
+		int n_wrong = 0;
+		for (int i = 0; i < side * side; i++) {
+			chunk->resetBlockData();
+			chunk->position = glm::ivec2(i % side - side / 2, i / side - side / 2);
+			loaded->resetBlockData();
+			loaded->position = chunk->position;
+			int found = store.loadChunk(loaded);
+			if (i % 3 != 0) {
+				n_wrong += found; // never saved
+				continue;
+			}
+			fillTestChunk(chunk, getPattern(i, version), i);
+			chunk->calculateHeightmap();
+			n_wrong += !found || !sameChunk(chunk, loaded);
+		}
+		check(n_wrong == 0, "regions", "loaded chunks differ from the saved ones");
+	}
+
+	std::filesystem::remove_all(directory);
+}
+
+int main(int argc, char **argv) {
+
+	const char *directory = argc > 1 ? argv[1] : "region_test_world";
+
+	Chunk *chunk = new Chunk;
+	Chunk *loaded = new Chunk;
+
+	testEncoding(chunk, loaded);
+	testRegions(directory, chunk, loaded);
+
+	delete chunk;
+	delete loaded;
+
+	if (n_failed == 0) {
+		printf("region_test: ok\n");
+	}
+	return n_failed == 0 ? 0 : 1;
+}
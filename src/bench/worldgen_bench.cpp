@@ -0,0 +1,182 @@
+// headless world generation and meshing benchmark (no window, no OpenGL context), JSON on stdout
+// build from src/: g++ -O2 -std=c++17 -Iinclude -IFastNoise2/include bench/worldgen_bench.cpp generator.cpp meshbuilder.cpp noise.cpp blockstorage.cpp profiler.cpp -LFastNoise2/lib -lFastNoise -o worldgen_bench
+// usage: worldgen_bench [chunks per side] [areas] [seed]
+// generates areas of (side + 2) x (side + 2) chunks at positions picked from the seed, and meshes the
+// side x side chunks inside (the outer ring gives them their neighbors), on one thread
+
+#include "generator.h"
+#include "chunk.h"
+#include "meshbuilder.h"
+#include "profiler.h"
+#include "random.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+// bytes and number of allocations made through operator new (vectors, snapshots...)
+// the block storages use malloc: their size is reported separately
+static long long allocatedBytes = 0;
+static long long allocationCount = 0;
+
+void *operator new(size_t size) {
+	allocatedBytes += size;
+	allocationCount++;
+	void *p = malloc(size ? size : 1);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+
+static double getSeconds() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// latency percentile in milliseconds (times are sorted)
+static double getPercentile(const std::vector<double> &times, double p) {
+	if (times.size() == 0) {
+		return 0.0;
+	}
+	int i = std::min((int)times.size() - 1, (int)(p * times.size()));
+	return times[i] * 1000.0;
+}
+
+// timing of one benchmarked step
+struct StepStats {
+	std::vector<double> times; // seconds per chunk
+	double total = 0.0;
+	long long bytes = 0;
+	long long allocations = 0;
+};
+
+static void printStep(const char *name, StepStats *stats, const char *extra) {
+	std::sort(stats->times.begin(), stats->times.end());
+	int n = stats->times.size();
+	printf("  \"%s\": { \"chunks\": %d, \"seconds\": %.4f, \"chunks_per_sec\": %.1f, "
+		"\"p50_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, \"alloc_bytes\": %lld, \"allocs\": %lld%s },\n",
+		name, n, stats->total, stats->total > 0 ? n / stats->total : 0.0,
+		getPercentile(stats->times, 0.5), getPercentile(stats->times, 0.99), getPercentile(stats->times, 1.0),
+		stats->bytes, stats->allocations, extra);
+}
+
+int main(int argc, char **argv) {
+
+	int side = argc > 1 ? atoi(argv[1]) : 16; // meshed chunks per side of an area
+	int areas = argc > 2 ? atoi(argv[2]) : 4;
+	int seed = argc > 3 ? atoi(argv[3]) : 1234;
+	int size = side + 2;
+
+	// the zones would count their ring in the allocations
+	Profiler::enabled = false;
+
+	WorldGenerator generator;
+	generator.init(seed);
+
+	StepStats generation, meshing;
+	long long n_vertices = 0;
+	long long blockMemory = 0;
+
+	std::vector<Chunk*> chunks(size * size);
+	for (int i = 0; i < size * size; i++) {
+		chunks[i] = new Chunk();
+	}
+	// one builder, like a worker thread (its buffers are reused from one chunk to the next)
+	MeshBuilder builder;
+	ChunkSnapshot *snapshot = builder.getSnapshot();
+
+	for (int area = 0; area < areas; area++) {
+
+		// spread the areas over the world, in a way that only depends on the seed
+		uint64_t h = mixRandom(((uint64_t)(uint32_t)seed << 32) | (uint32_t)area);
+		int x0 = (int)(h % 4000) - 2000;
+		int z0 = (int)((h >> 32) % 4000) - 2000;
+
+		// generation (what a generation job does)
+		for (int i = 0; i < size * size; i++) {
+			Chunk *chunk = chunks[i];
+			chunk->resetBlockData();
+			chunk->position = glm::ivec2(x0 + i % size, z0 + i / size);
+
+			long long bytes = allocatedBytes;
+			long long count = allocationCount;
+			double start = getSeconds();
+
+			generator.generateChunk(chunk, true);
+			chunk->compactSections();
+
+			double time = getSeconds() - start;
+			generation.times.push_back(time);
+			generation.total += time;
+			generation.bytes += allocatedBytes - bytes;
+			generation.allocations += allocationCount - count;
+
+			chunk->isGenerated = true;
+		}
+
+		// neighbor links, as the chunk manager makes them
+		for (int i = 0; i < size * size; i++) {
+			int x = i % size;
+			int z = i / size;
+			chunks[i]->neighbors[NEIGHBOR_LEFT] = x > 0 ? chunks[i - 1] : NULL;
+			chunks[i]->neighbors[NEIGHBOR_RIGHT] = x < size - 1 ? chunks[i + 1] : NULL;
+			chunks[i]->neighbors[NEIGHBOR_DOWN] = z > 0 ? chunks[i - size] : NULL;
+			chunks[i]->neighbors[NEIGHBOR_UP] = z < size - 1 ? chunks[i + size] : NULL;
+		}
+
+		// meshing (snapshot on the main thread + build on a worker, without the upload)
+		for (int z = 1; z < size - 1; z++) {
+			for (int x = 1; x < size - 1; x++) {
+				Chunk *chunk = chunks[z * size + x];
+
+				long long bytes = allocatedBytes;
+				long long count = allocationCount;
+				double start = getSeconds();
+
+				chunk->takeSnapshot(snapshot, ALL_SECTIONS);
+				const ChunkMesh *mesh = builder.build(snapshot);
+
+				double time = getSeconds() - start;
+				meshing.times.push_back(time);
+				meshing.total += time;
+				meshing.bytes += allocatedBytes - bytes;
+				meshing.allocations += allocationCount - count;
+
+				n_vertices += mesh->sectionStart[N_SECTIONS];
+				blockMemory += chunk->getBlockMemory();
+			}
+		}
+	}
+
+	int n_meshed = meshing.times.size();
+	char extra[256];
+
+	printf("{\n");
+	printf("  \"seed\": %d, \"areas\": %d, \"side\": %d, \"meshing\": \"%s\",\n",
+		seed, areas, side, Chunk::meshingMode == MESHING_GREEDY ? "greedy" : "naive");
+	printStep("generate", &generation, "");
+	snprintf(extra, sizeof(extra), ", \"vertices_per_chunk\": %.1f, \"block_bytes_per_chunk\": %.1f",
+		n_meshed ? (double)n_vertices / n_meshed : 0.0, n_meshed ? (double)blockMemory / n_meshed : 0.0);
+	printStep("mesh", &meshing, extra);
+	// a chunk is generated then meshed
+	double generationAverage = generation.times.size() ? generation.total / generation.times.size() : 0.0;
+	double meshingAverage = n_meshed ? meshing.total / n_meshed : 0.0;
+	printf("  \"total_chunks_per_sec\": %.1f\n", generationAverage + meshingAverage > 0 ? 1.0 / (generationAverage + meshingAverage) : 0.0);
+	printf("}\n");
+
+	for (int i = 0; i < size * size; i++) {
+		delete chunks[i];
+	}
+	return 0;
+}
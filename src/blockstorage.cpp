@@ -0,0 +1,224 @@
+#include "blockstorage.h"
+
+#include <cstdlib>
+#include <cstring>
+
+BlockStorage::BlockStorage() {
+	bits = 0;
+	data = NULL;
+	reset(BlockType::AIR);
+}
+
+BlockStorage::~BlockStorage() {
+	free(data);
+}
+
+void BlockStorage::reset(Block block) {
+	free(data);
+	data = NULL;
+	bits = 0;
+	updateLookup();
+
+	paletteSize = 1;
+	palette[0] = block;
+	counts[0] = STORAGE_SIZE;
+}
+
+// switches to a bigger (or smaller) index size, keeping the blocks
+void BlockStorage::setBits(int newBits) {
+
+	uint64_t *newData = NULL;
+	if (newBits > 0) {
+		newData = (uint64_t*)calloc(STORAGE_SIZE * newBits / 64, sizeof(uint64_t));
+	}
+
+	if (newBits == 8) {
+		// the blocks are stored directly
+		Block *blocks = reinterpret_cast<Block*>(newData);
+		for (int i = 0; i < STORAGE_SIZE; i++) {
+			blocks[i] = get(i);
+		}
+	}
+	else if (newBits > 0) {
+		// same palette, larger indices
+		int perWord = 64 / newBits;
+		for (int i = 0; i < STORAGE_SIZE; i++) {
+			uint64_t index = (bits == 0) ? 0 : (data[i >> wordShift] >> ((i & wordMask) * bits)) & indexMask;
+			newData[i / perWord] |= index << ((i % perWord) * newBits);
+		}
+	}
+
+	free(data);
+	data = newData;
+	bits = newBits;
+	updateLookup();
+}
+
+void BlockStorage::updateLookup() {
+	wordShift = wordMask = indexMask = 0;
+	if (bits > 0 && bits < 8) {
+		int perWord = 64 / bits;
+		while ((1 << wordShift) < perWord) {
+			wordShift++;
+		}
+		wordMask = perWord - 1;
+		indexMask = (1 << bits) - 1;
+	}
+}
+
+Block BlockStorage::set(int index, Block block) {
+
+	// 8 bits: no palette
+	if (bits == 8) {
+		Block *blocks = reinterpret_cast<Block*>(data);
+		Block previous = blocks[index];
+		blocks[index] = block;
+		return previous;
+	}
+
+	int previousIndex = (bits == 0) ? 0 : (data[index >> wordShift] >> ((index & wordMask) * bits)) & indexMask;
+	Block previous = palette[previousIndex];
+	if (previous == block) {
+		return previous;
+	}
+
+	// find the block in the palette, or a free entry for it
+	int newIndex = -1;
+	int freeIndex = -1;
+	for (int i = 0; i < paletteSize; i++) {
+		if (counts[i] > 0 && palette[i] == block) {
+			newIndex = i;
+			break;
+		}
+		if (counts[i] == 0 && freeIndex < 0) {
+			freeIndex = i;
+		}
+	}
+
+	if (newIndex < 0) {
+		if (freeIndex >= 0) {
+			newIndex = freeIndex;
+		}
+		else if (paletteSize < PALETTE_MAX_SIZE) {
+			newIndex = paletteSize++;
+		}
+		else {
+			// too many block types for a palette
+			setBits(8);
+			return set(index, block);
+		}
+		palette[newIndex] = block;
+		counts[newIndex] = 0;
+
+		// the indices need one more bit (0 -> 1 -> 2 -> 4)
+		if (paletteSize > (1 << bits)) {
+			setBits(bits == 0 ? 1 : bits * 2);
+		}
+	}
+
+	counts[previousIndex]--;
+	counts[newIndex]++;
+
+	int shift = (index & wordMask) * bits;
+	uint64_t *word = &data[index >> wordShift];
+	*word = (*word & ~((uint64_t)indexMask << shift)) | ((uint64_t)newIndex << shift);
+
+	return previous;
+}
+
+void BlockStorage::getRow(int index, int n, Block *out) const {
+	switch (bits) {
+	case 0:
+		memset(out, palette[0], n);
+		break;
+	case 8:
+		memcpy(out, reinterpret_cast<const Block*>(data) + index, n);
+		break;
+	default:
+		for (int i = 0; i < n; i++) {
+			out[i] = get(index + i);
+		}
+		break;
+	}
+}
+
+void BlockStorage::compact() {
+
+	if (bits == 0) {
+		return;
+	}
+
+	Block blocks[STORAGE_SIZE];
+	getRow(0, STORAGE_SIZE, blocks);
+	fill(blocks);
+}
+
+void BlockStorage::fill(const Block *blocks) {
+
+	// count the blocks of each type (by runs: sections are mostly long runs of the same block)
+	int typeCounts[256] = { 0 };
+	Block current = blocks[0];
+	int run = 0;
+	for (int i = 0; i < STORAGE_SIZE; i++) {
+		if (blocks[i] != current) {
+			typeCounts[current] += run;
+			current = blocks[i];
+			run = 0;
+		}
+		run++;
+	}
+	typeCounts[current] += run;
+
+	Block newPalette[PALETTE_MAX_SIZE];
+	unsigned short newCounts[PALETTE_MAX_SIZE];
+	unsigned char paletteIndex[256]; // block type -> index in the new palette
+	int newSize = 0;
+	for (int type = 0; type < 256; type++) {
+		if (typeCounts[type] == 0) {
+			continue;
+		}
+		if (newSize == PALETTE_MAX_SIZE) {
+			// too many types for a palette: store the blocks directly
+			free(data);
+			data = (uint64_t*)malloc(STORAGE_SIZE);
+			memcpy(data, blocks, STORAGE_SIZE);
+			bits = 8;
+			updateLookup();
+			return;
+		}
+		newPalette[newSize] = type;
+		newCounts[newSize] = typeCounts[type];
+		paletteIndex[type] = newSize;
+		newSize++;
+	}
+
+	int newBits = 0;
+	while ((1 << newBits) < newSize) {
+		newBits = (newBits == 0) ? 1 : newBits * 2;
+	}
+
+	if (newBits == 0) {
+		reset(newPalette[0]);
+		return;
+	}
+
+	// pack the indices with the new palette, one word at a time
+	int perWord = 64 / newBits;
+	uint64_t *newData = (uint64_t*)malloc(STORAGE_SIZE * newBits / 8);
+	for (int i = 0, w = 0; i < STORAGE_SIZE; i += perWord, w++) {
+		uint64_t word = 0;
+		for (int j = 0; j < perWord; j++) {
+			word |= (uint64_t)paletteIndex[blocks[i + j]] << (j * newBits);
+		}
+		newData[w] = word;
+	}
+
+	free(data);
+	data = newData;
+	bits = newBits;
+	updateLookup();
+
+	paletteSize = newSize;
+	memcpy(palette, newPalette, newSize);
+	memcpy(counts, newCounts, newSize * sizeof(unsigned short));
+}
@@ -0,0 +1,23 @@
+#include "chunk.h"
+#include "meshbuilder.h"
+#include "meshuploader.h"
+#include "profiler.h"
+
+void Chunk::calculateMesh(int sectionMask) {
+	PROFILE_ZONE("calculateMesh");
+
+	// the builder's snapshot and vertex buffers are reused: no allocation once they have grown
+	MeshBuilder *builder = MeshBuilder::getThreadBuilder();
+	ChunkSnapshot *snapshot = builder->getSnapshot();
+
+	takeSnapshot(snapshot, sectionMask);
+	uploader->upload(builder->build(snapshot), true);
+}
+
+void Chunk::releaseMesh() {
+	uploader->release(this);
+	for (int i = 0; i < N_SECTIONS; i++) {
+		sections[i].meshRevision++; // meshes still being built for the old position are dropped
+	}
+	isBuilt = false;
+}
@@ -1,28 +1,74 @@
 #include "chunkmanager.h"
 #include "world.h"
+#include "meshbuilder.h"
+#include "profiler.h"
+#include "gpustats.h"
+
+// squared distance between two chunk positions (used to process the closest chunks first)
+static int getChunkDistance(glm::ivec2 a, glm::ivec2 b) {
+	return (a.x - b.x)*(a.x - b.x) + (a.y - b.y)*(a.y - b.y);
+}
 
 ChunkManager::ChunkManager() {
 
 }
 
+ChunkManager::~ChunkManager() {
+	freeFrustumBoxes(&cullBoxes);
+}
+
 void ChunkManager::init() {
-	visibleChunks = (Chunk**)malloc(sizeof(Chunk*));
+	visibleChunks = NULL;
 	visibleChunks_size = 0;
+	toLoadPositions = NULL;
+	toLoadPositions_size = 0;
+
+	meshUploader.init();
+	Chunk::uploader = &meshUploader;
+
+	regionStore.init(WORLD_SAVE_DIR);
+
+	// keep one core for the main thread
+	int n_workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	workers.start(n_workers);
+
+	lodManager.init(&workers);
 }
 
 void ChunkManager::update(Camera *camera, int playerMoved) {
 
 	if (playerMoved) {
+		prefetchSavedChunks(camera);
+
 		requestChunkPositions(camera);
 
 		visibleChunks_size = toLoadPositions_size;
 
+		std::unique_lock<std::shared_mutex> lock(chunksMutex);
 		requestChunks();
 	}
 
+	generateRequestedChunks(camera);
+
+	{
+		std::unique_lock<std::shared_mutex> lock(chunksMutex);
+		finishGeneratedChunks();
+	}
+
 	buildUnbuiltChunks(camera);
 
-	checkFarChunks(camera);
+	{
+		std::unique_lock<std::shared_mutex> lock(chunksMutex);
+		checkFarChunks(camera);
+	}
+
+	lodManager.update(world, camera);
+
+	float time = static_cast<float>(glfwGetTime());
+	if (time - lastRegionReport > REGION_STATS_INTERVAL) {
+		regionStore.printLoadStats();
+		lastRegionReport = time;
+	}
 }
 
 float ChunkManager::getChunkDistanceFromCamera(Chunk *chunk, Camera *camera) {
@@ -30,86 +76,191 @@ float ChunkManager::getChunkDistanceFromCamera(Chunk *chunk, Camera *camera) {
 		+ (camera->Position.z - chunk->position.y)*(camera->Position.z - chunk->position.y);
 }
 
-// builds one unbuilt chunk (the closest one)
+// sends the closest ungenerated chunks to the workers
+void ChunkManager::generateRequestedChunks(Camera *camera) {
+
+	int freeJobs = MAX_GEN_JOBS - genJobsInFlight;
+	if (ungeneratedChunks.size() == 0 || freeJobs <= 0) {
+		return;
+	}
+
+	glm::ivec2 chunk_pos = getChunkPosition(&camera->Position);
+	int n = std::min((int)ungeneratedChunks.size(), freeJobs);
+
+	std::partial_sort(ungeneratedChunks.begin(), ungeneratedChunks.begin() + n, ungeneratedChunks.end(),
+		[chunk_pos](const auto& chunk_a, const auto& chunk_b) {
+		return getChunkDistance(chunk_pos, chunk_a->position) < getChunkDistance(chunk_pos, chunk_b->position);
+	});
+
+	for (int i = 0; i < n; i++) {
+		submitGenerationJob(ungeneratedChunks[i], getChunkDistance(chunk_pos, ungeneratedChunks[i]->position));
+	}
+	ungeneratedChunks.erase(ungeneratedChunks.begin(), ungeneratedChunks.begin() + n);
+}
+
+void ChunkManager::submitGenerationJob(Chunk *chunk, float priority) {
+
+	// the chunk is not linked to its neighbors yet: the worker is the only one touching its blocks
+	chunk->isGenerating = true;
+	genJobsInFlight++;
+
+	workers.submit(priority, [this, chunk]() {
+		GeneratedChunk *generated = new GeneratedChunk;
+		generated->chunk = chunk;
+
+		// chunks modified by the player come back from their region file
+		if (!regionStore.loadChunk(chunk)) {
+			world->generator.generateChunk(chunk, true);
+		}
+		chunk->compactSections();
+
+		std::lock_guard<std::mutex> lock(generatedChunksMutex);
+		generatedChunks.push_back(generated);
+	});
+}
+
+void ChunkManager::finishGeneratedChunks() {
+	PROFILE_ZONE("finishGeneratedChunks");
+
+	std::vector<GeneratedChunk*> chunks;
+	{
+		std::lock_guard<std::mutex> lock(generatedChunksMutex);
+		chunks.swap(generatedChunks);
+	}
+
+	for (int i = 0; i < chunks.size(); i++) {
+		Chunk *chunk = chunks[i]->chunk;
+
+		chunk->isGenerating = false;
+		chunk->isGenerated = true;
+		genJobsInFlight--;
+
+		linkNeighbors(chunk);
+
+		unbuiltChunks.push_back(chunk);
+
+		delete chunks[i];
+	}
+}
+
+void ChunkManager::linkNeighbors(Chunk *chunk) {
+
+	Chunk *neighbors[4];
+	neighbors[NEIGHBOR_UP] = getLoadedChunk(chunk->position.x, chunk->position.y + 1);
+	neighbors[NEIGHBOR_DOWN] = getLoadedChunk(chunk->position.x, chunk->position.y - 1);
+	neighbors[NEIGHBOR_LEFT] = getLoadedChunk(chunk->position.x - 1, chunk->position.y);
+	neighbors[NEIGHBOR_RIGHT] = getLoadedChunk(chunk->position.x + 1, chunk->position.y);
+
+	// opposite direction of each neighbor (up, down, left, right)
+	int opposite[4] = { NEIGHBOR_DOWN, NEIGHBOR_UP, NEIGHBOR_RIGHT, NEIGHBOR_LEFT };
+
+	for (int i = 0; i < 4; i++) {
+		if (neighbors[i] != NULL && neighbors[i]->isGenerated) {
+			chunk->neighbors[i] = neighbors[i];
+			neighbors[i]->neighbors[opposite[i]] = chunk;
+		}
+	}
+}
+
+// sends the closest unbuilt chunks to the workers and uploads the meshes they built
 void ChunkManager::buildUnbuiltChunks(Camera *camera) {
+	PROFILE_ZONE("buildUnbuiltChunks");
 
-	if (unbuiltChunks.size() != 0) {
-		glm::ivec2 chunk_pos = getChunkPosition(&camera->Position);
+	glm::ivec2 chunk_pos = getChunkPosition(&camera->Position);
 
-		// sort the vector WARNING BETTER TO DO IT AT THE END OF REQUEST CHUNKS!!!!!!!
-		std::sort(unbuiltChunks.begin(), unbuiltChunks.end(),
-			[chunk_pos](const auto& chunk_a, const auto& chunk_b) {
+	int freeJobs = MAX_MESH_JOBS - meshJobsInFlight;
+	if (unbuiltChunks.size() != 0 && freeJobs > 0) {
+
+		int n = std::min((int)unbuiltChunks.size(), freeJobs);
 
-			return (chunk_pos.x - chunk_a->position.x)*(chunk_pos.x - chunk_a->position.x)
-				+ (chunk_pos.y - chunk_a->position.y)*(chunk_pos.y - chunk_a->position.y)
-				<
-				(chunk_pos.x - chunk_b->position.x)*(chunk_pos.x - chunk_b->position.x)
-				+ (chunk_pos.y - chunk_b->position.y)*(chunk_pos.y - chunk_b->position.y);
+		// only the chunks that are sent this frame need to be sorted
+		std::partial_sort(unbuiltChunks.begin(), unbuiltChunks.begin() + n, unbuiltChunks.end(),
+			[chunk_pos](const auto& chunk_a, const auto& chunk_b) {
+			return getChunkDistance(chunk_pos, chunk_a->position) < getChunkDistance(chunk_pos, chunk_b->position);
 		});
 
-		Chunk *chunk = unbuiltChunks[0];
-		unbuiltChunks.erase(unbuiltChunks.begin()); // remove it from the build list
+		for (int i = 0; i < n; i++) {
+			submitMeshJob(unbuiltChunks[i], getChunkDistance(chunk_pos, unbuiltChunks[i]->position));
+		}
+		unbuiltChunks.erase(unbuiltChunks.begin(), unbuiltChunks.begin() + n); // remove them from the build list
+	}
+
+	uploadBuiltMeshes();
 
-		// build the chunk
-		chunk->calculateMesh();
-		/*std::thread t = chunk->calculateMeshThreaded();
-		t.join();
-		// t.detach();*/
+	if (reportMeshStats && unbuiltChunks.size() == 0 && meshJobsInFlight == 0) {
+		printMeshStats();
+		reportMeshStats = false;
+	}
+}
+
+void ChunkManager::submitMeshJob(Chunk *chunk, float priority) {
+
+	// the snapshot is taken now: the chunk can keep changing while the mesh is built
+	ChunkSnapshot *snapshot = new ChunkSnapshot;
+	chunk->takeSnapshot(snapshot, ALL_SECTIONS);
+
+	chunk->meshJobs++;
+	meshJobsInFlight++;
+
+	workers.submit(priority, [this, snapshot]() {
+		// built in the worker's own buffers, then copied at its exact size to wait for the upload
+		ChunkMesh *mesh = MeshBuilder::getThreadBuilder()->buildCopy(snapshot);
+		delete snapshot;
+
+		std::lock_guard<std::mutex> lock(builtMeshesMutex);
+		builtMeshes.push_back(mesh);
+	});
+}
+
+void ChunkManager::uploadBuiltMeshes() {
+	PROFILE_ZONE("uploadBuiltMeshes");
+
+	std::vector<ChunkMesh*> meshes;
+	{
+		std::lock_guard<std::mutex> lock(builtMeshesMutex);
+		meshes.swap(builtMeshes);
+	}
+
+	float start_time = static_cast<float>(glfwGetTime());
+
+	int size = meshes.size();
+	int i = 0;
+	// always upload at least one mesh so that building never stops
+	for (; i < size && (i == 0 || static_cast<float>(glfwGetTime()) - start_time < MESH_UPLOAD_BUDGET); i++) {
+		ChunkMesh *mesh = meshes[i];
+
+		// sections that changed since the snapshot are dropped
+		meshUploader.upload(mesh);
+
+		mesh->chunk->meshJobs--;
+		delete mesh;
+		meshJobsInFlight--;
+	}
+
+	// keep the remaining meshes for the next frame
+	if (i < size) {
+		std::lock_guard<std::mutex> lock(builtMeshesMutex);
+		builtMeshes.insert(builtMeshes.begin(), meshes.begin() + i, meshes.end());
 	}
 }
 
 
 // request chunks into visible chunks
 Chunk** ChunkManager::requestChunks() {
+	PROFILE_ZONE("requestChunks");
 
 	int size = toLoadPositions_size;
 
-	// don't do this every frame? only at start? idk (or use loadedChunks instead)
+	free(visibleChunks);
 	visibleChunks = (Chunk**)malloc(size * sizeof(Chunk*));
 
-	float debug_start_frame = static_cast<float>(glfwGetTime());
-
 	for (int i = 0; i < size; i++) {
 
-		int loadedSize = loadedChunks.size();
 		int chunk_x = toLoadPositions[i].x;
 		int chunk_y = toLoadPositions[i].y;
 
-		Chunk *neighbors[4] = { NULL, NULL, NULL, NULL };
-
 		// try to find the requested chunk in the currently loaded chunks
-		// only stop when neighbors and found chunk are found
-		Chunk *found = NULL;
-		for (int j = 0;
-			j < loadedSize && (found == NULL || neighbors[0] == NULL || neighbors[1] == NULL || neighbors[2] == NULL || neighbors[3] == NULL);
-			j++)
-		{					// && found == NULL
-
-			if (found == NULL
-				&& loadedChunks[j]->position.x == chunk_x
-				&& loadedChunks[j]->position.y == chunk_y) {
-
-				found = loadedChunks[j];
-			}
-
-			// check neighbors
-			if (loadedChunks[j]->position.x == chunk_x
-				&& loadedChunks[j]->position.y == chunk_y + 1) {
-				neighbors[NEIGHBOR_UP] = loadedChunks[j];
-			}
-			if (loadedChunks[j]->position.x == chunk_x
-				&& loadedChunks[j]->position.y == chunk_y - 1) {
-				neighbors[NEIGHBOR_DOWN] = loadedChunks[j];
-			}
-			if (loadedChunks[j]->position.x == chunk_x - 1
-				&& loadedChunks[j]->position.y == chunk_y) {
-				neighbors[NEIGHBOR_LEFT] = loadedChunks[j];
-			}
-			if (loadedChunks[j]->position.x == chunk_x + 1
-				&& loadedChunks[j]->position.y == chunk_y) {
-				neighbors[NEIGHBOR_RIGHT] = loadedChunks[j];
-			}
-		}
+		Chunk *found = loadedChunks.find(chunk_x, chunk_y);
 
 		if (found) {
 			// the requested chunk already exists in the loaded chunks
@@ -126,58 +277,26 @@ Chunk** ChunkManager::requestChunks() {
 				unbuiltChunks.push_back(found);
 			}*/
 
-			// add blocks that were cached (placed by other chunks before this one was loaded)
-			int hash = world->getChunkPosHash(found->position.x, found->position.y);
-			if (world->cachedBlocks.find(hash) != world->cachedBlocks.end()) { // if we found an entry for this chunk
-				int size = world->cachedBlocks[hash].size();
-				for (int i = 0; i < size; i++) {
-					// std::cout << "TRY PLACE BLOCK AT: "
-					found->setBlock(world->cachedBlocks[hash][i].x,
-						world->cachedBlocks[hash][i].y,
-						world->cachedBlocks[hash][i].z, world->cachedBlocks[hash][i].type);
-				}
-				world->cachedBlocks.erase(hash);
-
-				// need to regenerate chunk mesh
-				unbuiltChunks.push_back(found);
+			// still being generated: it will be linked to its neighbors once done
+			if (!found->isGenerated) {
+				continue;
 			}
-
 		}
 		else {
-			// the requested chunk doesn't exist yet: create it
-			Chunk *chunk = (Chunk*)malloc(sizeof(Chunk));
-			chunk->resetBlockData();
-			// chunk->isBuilt = false;
-			chunk->position = glm::ivec2(chunk_x, chunk_y);
+			// the requested chunk doesn't exist yet: create it and queue its generation
+			Chunk *chunk = chunkPool.acquire(chunk_x, chunk_y);
 
-			world->generateChunk(chunk, true);
-
-			loadedChunks.push_back(chunk);
-			unbuiltChunks.push_back(chunk);
+			loadedChunks.insert(chunk);
+			ungeneratedChunks.push_back(chunk);
 			visibleChunks[i] = chunk;
+
+			continue;
 		}
 
 		// update neighbors and link them
-		if (neighbors[NEIGHBOR_UP] != NULL) {
-			visibleChunks[i]->neighbors[NEIGHBOR_UP] = neighbors[NEIGHBOR_UP];
-			neighbors[NEIGHBOR_UP]->neighbors[NEIGHBOR_DOWN] = visibleChunks[i];
-		}
-		if (neighbors[NEIGHBOR_DOWN] != NULL) {
-			visibleChunks[i]->neighbors[NEIGHBOR_DOWN] = neighbors[NEIGHBOR_DOWN];
-			neighbors[NEIGHBOR_DOWN]->neighbors[NEIGHBOR_UP] = visibleChunks[i];
-		}
-		if (neighbors[NEIGHBOR_LEFT] != NULL) {
-			visibleChunks[i]->neighbors[NEIGHBOR_LEFT] = neighbors[NEIGHBOR_LEFT];
-			neighbors[NEIGHBOR_LEFT]->neighbors[NEIGHBOR_RIGHT] = visibleChunks[i];
-		}
-		if (neighbors[NEIGHBOR_RIGHT] != NULL) {
-			visibleChunks[i]->neighbors[NEIGHBOR_RIGHT] = neighbors[NEIGHBOR_RIGHT];
-			neighbors[NEIGHBOR_RIGHT]->neighbors[NEIGHBOR_LEFT] = visibleChunks[i];
-		}
+		linkNeighbors(visibleChunks[i]);
 	}
 
-	// std::cout << "REQUEST CHUNKS TOOK: " << static_cast<float>(glfwGetTime()) - debug_start_frame << "\n";
-
 	return visibleChunks;
 }
 
@@ -203,37 +322,117 @@ glm::ivec2 ChunkManager::getChunkPosition(glm::vec3 *position) {
 	return glm::ivec2(p_x, p_z);
 }
 
-// WARNING: CURRENTLY NOT FREEING ANYTHING
+// unloads the chunks that are out of range and gives them back to the pool
 void ChunkManager::checkFarChunks(Camera *camera) {
+	PROFILE_ZONE("checkFarChunks");
 
-	std::vector<Chunk*> newChunks;
 	std::vector<Chunk*> chunksToFree;
 
 	// calculate in which chunk the player currently is
 	glm::ivec2 chunk_pos = getChunkPosition(&camera->Position);
 
-	int size = loadedChunks.size();
-	for (int i = 0; i < size; i++) {
-		if ((abs(loadedChunks[i]->position.x - chunk_pos.x) > RENDER_DISTANCE
-			|| abs(loadedChunks[i]->position.y - chunk_pos.y) > RENDER_DISTANCE)
-			&& !loadedChunks[i]->used) {
+	// chunks that went out of range before being sent to the workers are not generated at all
+	ungeneratedChunks.erase(std::remove_if(ungeneratedChunks.begin(), ungeneratedChunks.end(),
+		[chunk_pos](Chunk *chunk) {
+		return abs(chunk->position.x - chunk_pos.x) > RENDER_DISTANCE
+			|| abs(chunk->position.y - chunk_pos.y) > RENDER_DISTANCE;
+	}), ungeneratedChunks.end());
 
-			loadedChunks[i]->removeNeighbors();
-			chunksToFree.push_back(loadedChunks[i]);
-		}
-		else {
-			newChunks.push_back(loadedChunks[i]);
+	int capacity = loadedChunks.capacity();
+	for (int i = 0; i < capacity; i++) {
+		Chunk *chunk = loadedChunks.at(i);
+
+		// chunks being generated are kept until their worker is done
+		if (chunk != NULL
+			&& (abs(chunk->position.x - chunk_pos.x) > RENDER_DISTANCE
+			|| abs(chunk->position.y - chunk_pos.y) > RENDER_DISTANCE)
+			&& !chunk->isGenerating) {
+
+			chunksToFree.push_back(chunk);
 		}
 	}
 
+	if (chunksToFree.size() == 0) {
+		return;
+	}
+
+	auto isFreed = [&chunksToFree](Chunk *chunk) {
+		return std::find(chunksToFree.begin(), chunksToFree.end(), chunk) != chunksToFree.end();
+	};
+
+	// nothing can reference the chunks once they are back in the pool
+	unbuiltChunks.erase(std::remove_if(unbuiltChunks.begin(), unbuiltChunks.end(), isFreed), unbuiltChunks.end());
+	if (visibleChunks != NULL) {
+		visibleChunks_size = std::remove_if(visibleChunks, visibleChunks + visibleChunks_size, isFreed) - visibleChunks;
+	}
+
+	// the map can't be modified while iterating on it
 	for (int i = 0; i < chunksToFree.size(); i++) {
-		// free(chunksToFree[i]);
+		Chunk *chunk = chunksToFree[i];
+		if (chunk->isGenerated && chunk->used) {
+			regionStore.saveChunk(chunk);
+		}
+		chunk->removeNeighbors();
+		loadedChunks.erase(chunk->position.x, chunk->position.y);
+		chunkPool.release(chunk);
 	}
 
-	loadedChunks.clear();
-	for (int i = 0; i < newChunks.size(); i++) {
-		loadedChunks.push_back(newChunks[i]);
+	submitFlushJob();
+}
+
+void ChunkManager::submitFlushJob() {
+
+	if (regionStore.flushQueued || !regionStore.hasPendingChunks()) {
+		return;
 	}
+
+	// runs before the generation and mesh jobs (their priority is a distance)
+	regionStore.flushQueued = true;
+	workers.submit(-1.0f, [this]() {
+		regionStore.flushQueued = false; // chunks saved from now on need another flush
+		regionStore.flush();
+	});
+}
+
+void ChunkManager::prefetchSavedChunks(Camera *camera) {
+
+	glm::ivec2 chunk_pos = getChunkPosition(&camera->Position);
+	glm::ivec2 step = glm::ivec2((chunk_pos.x > lastPlayerChunk.x) - (chunk_pos.x < lastPlayerChunk.x),
+		(chunk_pos.y > lastPlayerChunk.y) - (chunk_pos.y < lastPlayerChunk.y));
+	if (step.x == 0 && step.y == 0) {
+		return;
+	}
+	lastPlayerChunk = chunk_pos;
+
+	// rows of chunks that will enter the render distance next: their sectors are read by the system
+	// while the player gets there, so the generation jobs find them in memory
+	// on a worker: region files may have to be opened, and the flush holds their locks
+	workers.submit(0.0f, [this, chunk_pos, step]() {
+		for (int d = 1; d <= REGION_PREFETCH_DISTANCE; d++) {
+			int reach = RENDER_DISTANCE + d;
+			if (step.x != 0) {
+				int x = chunk_pos.x + step.x * reach;
+				regionStore.prefetchChunks(x, chunk_pos.y - reach, x, chunk_pos.y + reach);
+			}
+			if (step.y != 0) {
+				int z = chunk_pos.y + step.y * reach;
+				regionStore.prefetchChunks(chunk_pos.x - reach, z, chunk_pos.x + reach, z);
+			}
+		}
+	});
+}
+
+void ChunkManager::saveModifiedChunks() {
+
+	int capacity = loadedChunks.capacity();
+	for (int i = 0; i < capacity; i++) {
+		Chunk *chunk = loadedChunks.at(i);
+		if (chunk != NULL && chunk->isGenerated && chunk->used) {
+			regionStore.saveChunk(chunk);
+		}
+	}
+
+	regionStore.flush();
 }
 
 // better as a camera member class?
@@ -266,33 +465,114 @@ void ChunkManager::requestChunkPositions(Camera *camera) {
 	toLoadPositions_size = size;
 }
 
-void ChunkManager::renderChunks(Shader* shader) {
+void ChunkManager::renderChunks(Shader* shader, Camera *camera) {
+	PROFILE_ZONE("renderChunks");
 
 	shader->use();
-	if (visibleChunks != NULL) {
+	if (visibleChunks == NULL) {
+		return;
+	}
+
+	// bounding box of each section that has something to draw (vertices are on block corners)
+	// empty and buried sections have no mesh, they are never tested
+	clearFrustumBoxes(&cullBoxes);
+	cullSections.clear();
+	for (int i = 0; i < visibleChunks_size; i++) {
+		Chunk *chunk = visibleChunks[i];
+		if (!chunk->isBuilt) {
+			continue;
+		}
+		for (int j = 0; j < N_SECTIONS; j++) {
+			if (chunk->sections[j].n_meshVertices > 0) {
+				glm::vec3 origin = glm::vec3(chunk->position.x * CHUNK_SIZE, j * SECTION_HEIGHT, chunk->position.y * CHUNK_SIZE);
+				addFrustumBox(&cullBoxes,
+					origin - glm::vec3(0.5f, 0.5f, 0.5f),
+					origin + glm::vec3(CHUNK_SIZE - 0.5f, Chunk::getSectionHeight(j) - 0.5f, CHUNK_SIZE - 0.5f));
+				cullSections.push_back({ chunk, j });
+			}
+		}
+	}
 
-		for (int i = 0; i < visibleChunks_size; i++) {
-			// MOVE THE CHECK SOMEWHERE ELSE?
-			if (visibleChunks[i]->isBuilt) {
-				visibleChunks[i]->render(shader);
+	Frustum frustum;
+	extractFrustum(&frustum, getProjectionMatrix(camera) * camera->GetViewMatrix());
+
+	cullVisible.resize(cullSections.size());
+	sectionsDrawn = cullFrustumBoxes(&frustum, &cullBoxes, cullVisible.data());
+	sectionsCulled = cullSections.size() - sectionsDrawn;
+
+	MeshArena *arena = meshUploader.getArena();
+	arena->beginDraws();
+	int n_chunksDrawn = 0;
+	Chunk *lastChunk = NULL; // the sections of a chunk follow each other
+	for (int i = 0; i < cullSections.size(); i++) {
+		if (cullVisible[i]) {
+			Chunk *chunk = cullSections[i].chunk;
+			ChunkSection *section = &chunk->sections[cullSections[i].section];
+			arena->addDraw(section->meshOffset, section->n_meshVertices, chunk->position.x, chunk->position.y);
+			if (chunk != lastChunk) {
+				n_chunksDrawn++;
+				lastChunk = chunk;
 			}
 		}
 	}
+	arena->endDraws();
+	GpuStats::addChunks(n_chunksDrawn, sectionsDrawn);
 }
 
-Chunk *ChunkManager::getPlayerChunk(Camera *camera) {
+void ChunkManager::rebuildAllChunks() {
 
-	glm::ivec2 chunk_pos = getChunkPosition(&camera->Position);
-	int loadedSize = loadedChunks.size();
+	int capacity = loadedChunks.capacity();
+	for (int i = 0; i < capacity; i++) {
+		Chunk *chunk = loadedChunks.at(i);
+		if (chunk != NULL && chunk->isGenerated
+			&& std::find(unbuiltChunks.begin(), unbuiltChunks.end(), chunk) == unbuiltChunks.end()) {
+			unbuiltChunks.push_back(chunk);
+		}
+	}
 
-	Chunk *found = NULL;
-	for (int i = 0; i < loadedSize && found == NULL; i++) {
-		if (loadedChunks[i]->position.x == chunk_pos.x
-			&& loadedChunks[i]->position.y == chunk_pos.y) {
+	reportMeshStats = true;
+}
+
+void ChunkManager::printMeshStats() {
 
-			found = loadedChunks[i];
+	long long n_vertices = 0;
+	long long blockMemory = 0;
+	int n_chunks = 0;
+
+	int capacity = loadedChunks.capacity();
+	for (int i = 0; i < capacity; i++) {
+		Chunk *chunk = loadedChunks.at(i);
+		if (chunk != NULL && chunk->isBuilt) {
+			n_vertices += chunk->getMeshVertices();
+			blockMemory += chunk->getBlockMemory();
+			n_chunks++;
 		}
 	}
 
+	std::cout << "mesh stats (" << (Chunk::meshingMode == MESHING_GREEDY ? "greedy" : "naive") << "): "
+		<< n_chunks << " chunks | "
+		<< n_vertices << " vertices | "
+		<< (n_chunks ? n_vertices / n_chunks : 0) << " vertices/chunk | "
+		<< (n_vertices * CHUNK_VERTEX_SIZE * sizeof(unsigned int)) / 1024 << " KB of vertices | "
+		<< ((long long)meshUploader.getArena()->getUsed() * MESH_VERTEX_BYTES) / 1024 << " / "
+		<< ((long long)meshUploader.getArena()->getCapacity() * MESH_VERTEX_BYTES) / 1024 << " KB of mesh arena used"
+		<< (meshUploader.getArena()->usesMultiDraw() ? "" : " (no multi draw)") << " | "
+		<< blockMemory / 1024 << " KB of block indices (" << (n_chunks ? blockMemory / n_chunks : 0) << " B/chunk)\n";
+}
+
+// returns NULL if the player's chunk has not been generated yet
+Chunk *ChunkManager::getPlayerChunk(Camera *camera) {
+
+	glm::ivec2 chunk_pos = getChunkPosition(&camera->Position);
+
+	Chunk *found = getLoadedChunk(chunk_pos.x, chunk_pos.y);
+	if (found != NULL && !found->isGenerated) {
+		return NULL;
+	}
+
 	return found;
+}
+
+Chunk *ChunkManager::getLoadedChunk(int x, int z) {
+	return loadedChunks.find(x, z);
 }
\ No newline at end of file
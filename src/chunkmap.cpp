@@ -0,0 +1,121 @@
+#include "chunkmap.h"
+#include "chunk.h"
+
+#include <cstdlib>
+
+static unsigned int hashChunkPosition(int x, int z) {
+	// mix both coordinates so that neighboring chunks spread over the table
+	unsigned int h = static_cast<unsigned int>(x) * 0x9E3779B1u ^ static_cast<unsigned int>(z) * 0x85EBCA77u;
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 13;
+	return h;
+}
+
+ChunkMap::ChunkMap() {
+	slots = NULL;
+	slots_size = 0;
+	count = 0;
+	resize(CHUNK_MAP_MIN_CAPACITY);
+}
+
+ChunkMap::~ChunkMap() {
+	free(slots);
+}
+
+int ChunkMap::findSlot(int x, int z) const {
+
+	int mask = slots_size - 1;
+	int i = hashChunkPosition(x, z) & mask;
+
+	while (slots[i].chunk != NULL && (slots[i].key.x != x || slots[i].key.y != z)) {
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+Chunk *ChunkMap::find(int x, int z) const {
+	return slots[findSlot(x, z)].chunk;
+}
+
+void ChunkMap::insert(Chunk *chunk) {
+
+	// keep the load factor under 1/2 so that probe sequences stay short
+	if ((count + 1) * 2 > slots_size) {
+		resize(slots_size * 2);
+	}
+
+	int i = findSlot(chunk->position.x, chunk->position.y);
+	if (slots[i].chunk == NULL) {
+		count++;
+	}
+
+	slots[i].key = chunk->position;
+	slots[i].chunk = chunk;
+}
+
+void ChunkMap::erase(int x, int z) {
+
+	int mask = slots_size - 1;
+	int i = findSlot(x, z);
+	if (slots[i].chunk == NULL) {
+		return;
+	}
+
+	slots[i].chunk = NULL;
+	count--;
+
+	// backward shift: move up the following entries of the probe sequence so that no tombstone is needed
+	int j = i;
+	while (true) {
+		j = (j + 1) & mask;
+		if (slots[j].chunk == NULL) {
+			break;
+		}
+
+		int home = hashChunkPosition(slots[j].key.x, slots[j].key.y) & mask;
+
+		// the entry can fill the hole only if its home slot is not between the hole and itself
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			slots[i] = slots[j];
+			slots[j].chunk = NULL;
+			i = j;
+		}
+	}
+}
+
+void ChunkMap::clear() {
+	for (int i = 0; i < slots_size; i++) {
+		slots[i].chunk = NULL;
+	}
+	count = 0;
+}
+
+void ChunkMap::resize(int new_size) {
+
+	Slot *old_slots = slots;
+	int old_size = slots_size;
+
+	slots = (Slot*)malloc(new_size * sizeof(Slot));
+	if (slots == NULL) {
+		std::cout << "Error ChunkMap::resize(): could not allocate memory\n";
+	}
+	slots_size = new_size;
+
+	for (int i = 0; i < slots_size; i++) {
+		slots[i].chunk = NULL;
+	}
+
+	// re-insert the previous entries
+	count = 0;
+	for (int i = 0; i < old_size; i++) {
+		if (old_slots[i].chunk != NULL) {
+			int j = findSlot(old_slots[i].key.x, old_slots[i].key.y);
+			slots[j] = old_slots[i];
+			count++;
+		}
+	}
+
+	free(old_slots);
+}
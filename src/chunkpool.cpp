@@ -0,0 +1,53 @@
+#include "chunkpool.h"
+#include "chunk.h"
+
+ChunkPool::~ChunkPool() {
+	for (int i = 0; i < freeChunks.size(); i++) {
+		delete freeChunks[i];
+	}
+}
+
+Chunk *ChunkPool::acquire(int x, int z) {
+
+	Chunk *chunk;
+	if (freeChunks.size() > 0) {
+		chunk = freeChunks.back();
+		freeChunks.pop_back();
+		chunk->resetBlockData();
+	}
+	else {
+		chunk = new Chunk();
+		n_allocated++;
+	}
+
+	chunk->position = glm::ivec2(x, z);
+
+	// the chunks kept past the limit for their meshes may be done now
+	trim();
+
+	return chunk;
+}
+
+void ChunkPool::release(Chunk *chunk) {
+
+	chunk->releaseMesh();
+
+	// a chunk with meshes in flight is always kept: the workers' results still point to it
+	// (deleted by a later trim)
+	freeChunks.push_back(chunk);
+	trim();
+}
+
+void ChunkPool::trim() {
+
+	for (int i = 0; i < freeChunks.size() && freeChunks.size() > CHUNK_POOL_MAX_FREE; ) {
+		if (freeChunks[i]->meshJobs > 0) {
+			i++;
+			continue;
+		}
+		delete freeChunks[i];
+		n_allocated--;
+		freeChunks[i] = freeChunks.back();
+		freeChunks.pop_back();
+	}
+}
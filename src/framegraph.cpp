@@ -0,0 +1,80 @@
+#include "framegraph.h"
+#include "gpustats.h"
+
+#include <algorithm>
+#include <cstring>
+
+// area of the graph in normalized device coordinates
+#define GRAPH_LEFT -0.98f
+#define GRAPH_BOTTOM -0.98f
+#define GRAPH_WIDTH 0.8f
+#define GRAPH_HEIGHT 0.4f
+
+void FrameGraph::init() {
+
+	shader = Shader("shaders/graph_v.vert", "shaders/graph_f.frag");
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), NULL, GL_DYNAMIC_DRAW);
+
+	// position attribute
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, FRAME_GRAPH_VERTEX_SIZE * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	// color attribute
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, FRAME_GRAPH_VERTEX_SIZE * sizeof(float), (void*)(2 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+
+	glBindVertexArray(0);
+}
+
+void FrameGraph::pushLine(float x0, float y0, float x1, float y1, float r, float g, float b) {
+	float line[2 * FRAME_GRAPH_VERTEX_SIZE] = { x0, y0, r, g, b, x1, y1, r, g, b };
+	memcpy(&vertices[n_vertices * FRAME_GRAPH_VERTEX_SIZE], line, sizeof(line));
+	n_vertices += 2;
+}
+
+void FrameGraph::render() {
+
+	int n = Profiler::getFrameTimes(times, PROFILER_FRAMES);
+	n_vertices = 0;
+
+	// one vertical bar per frame, the newest on the right
+	float barWidth = GRAPH_WIDTH / PROFILER_FRAMES;
+	for (int i = 0; i < n; i++) {
+		float x = GRAPH_LEFT + (PROFILER_FRAMES - n + i + 0.5f) * barWidth;
+		float height = std::min(times[i] / FRAME_GRAPH_SCALE, 1.0f) * GRAPH_HEIGHT;
+		if (times[i] <= FRAME_GRAPH_TARGET) {
+			pushLine(x, GRAPH_BOTTOM, x, GRAPH_BOTTOM + height, 0.2f, 0.9f, 0.2f);
+		}
+		else if (times[i] <= FRAME_GRAPH_TARGET * 2.0f) {
+			pushLine(x, GRAPH_BOTTOM, x, GRAPH_BOTTOM + height, 0.9f, 0.9f, 0.2f);
+		}
+		else {
+			pushLine(x, GRAPH_BOTTOM, x, GRAPH_BOTTOM + height, 0.9f, 0.2f, 0.2f);
+		}
+	}
+
+	// baseline and 60 / 30 FPS lines
+	float right = GRAPH_LEFT + GRAPH_WIDTH;
+	float target = GRAPH_BOTTOM + FRAME_GRAPH_TARGET / FRAME_GRAPH_SCALE * GRAPH_HEIGHT;
+	float target2 = GRAPH_BOTTOM + FRAME_GRAPH_TARGET * 2.0f / FRAME_GRAPH_SCALE * GRAPH_HEIGHT;
+	pushLine(GRAPH_LEFT, GRAPH_BOTTOM, right, GRAPH_BOTTOM, 1.0f, 1.0f, 1.0f);
+	pushLine(GRAPH_LEFT, target, right, target, 1.0f, 1.0f, 1.0f);
+	pushLine(GRAPH_LEFT, target2, right, target2, 0.5f, 0.5f, 0.5f);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, n_vertices * FRAME_GRAPH_VERTEX_SIZE * sizeof(float), vertices);
+
+	// drawn over everything
+	glDisable(GL_DEPTH_TEST);
+	shader.use();
+	glBindVertexArray(VAO);
+	glDrawArrays(GL_LINES, 0, n_vertices);
+	GpuStats::addDraw(n_vertices);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,112 @@
+#include "frustum.h"
+
+#include <cstdlib>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+void extractFrustum(Frustum *frustum, const glm::mat4 &m) {
+
+	// rows of the matrix (glm is column major)
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 4; j++) {
+			float row = m[j][i];
+			float w = m[j][3];
+			frustum->planes[i * 2][j] = w + row; // left, bottom, near
+			frustum->planes[i * 2 + 1][j] = w - row; // right, top, far
+		}
+	}
+}
+
+void clearFrustumBoxes(FrustumBoxes *boxes) {
+	boxes->size = 0;
+}
+
+void addFrustumBox(FrustumBoxes *boxes, glm::vec3 min, glm::vec3 max) {
+
+	if (boxes->size == boxes->capacity) {
+		int capacity = boxes->capacity ? boxes->capacity * 2 : 256;
+		float **arrays[6] = { &boxes->minX, &boxes->minY, &boxes->minZ, &boxes->maxX, &boxes->maxY, &boxes->maxZ };
+		for (int i = 0; i < 6; i++) {
+			*arrays[i] = (float*)realloc(*arrays[i], capacity * sizeof(float));
+		}
+		boxes->capacity = capacity;
+	}
+
+	int i = boxes->size++;
+	boxes->minX[i] = min.x;
+	boxes->minY[i] = min.y;
+	boxes->minZ[i] = min.z;
+	boxes->maxX[i] = max.x;
+	boxes->maxY[i] = max.y;
+	boxes->maxZ[i] = max.z;
+}
+
+void freeFrustumBoxes(FrustumBoxes *boxes) {
+	free(boxes->minX);
+	free(boxes->minY);
+	free(boxes->minZ);
+	free(boxes->maxX);
+	free(boxes->maxY);
+	free(boxes->maxZ);
+	boxes->minX = boxes->minY = boxes->minZ = NULL;
+	boxes->maxX = boxes->maxY = boxes->maxZ = NULL;
+	boxes->size = 0;
+	boxes->capacity = 0;
+}
+
+// a box is outside a plane if its corner furthest along the plane normal is behind it
+static int cullBox(const Frustum *frustum, const FrustumBoxes *boxes, int i) {
+	for (int p = 0; p < FRUSTUM_PLANES; p++) {
+		const float *plane = frustum->planes[p];
+		float x = plane[0] > 0.0f ? boxes->maxX[i] : boxes->minX[i];
+		float y = plane[1] > 0.0f ? boxes->maxY[i] : boxes->minY[i];
+		float z = plane[2] > 0.0f ? boxes->maxZ[i] : boxes->minZ[i];
+		if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+int cullFrustumBoxes(const Frustum *frustum, const FrustumBoxes *boxes, unsigned char *visible) {
+
+	int n_visible = 0;
+	int i = 0;
+
+#ifdef FRUSTUM_SSE
+	// the furthest corner is picked per plane, so the same arrays are loaded for the four boxes
+	for (; i + 4 <= boxes->size; i += 4) {
+		__m128 outside = _mm_setzero_ps();
+
+		for (int p = 0; p < FRUSTUM_PLANES; p++) {
+			const float *plane = frustum->planes[p];
+			__m128 x = _mm_loadu_ps((plane[0] > 0.0f ? boxes->maxX : boxes->minX) + i);
+			__m128 y = _mm_loadu_ps((plane[1] > 0.0f ? boxes->maxY : boxes->minY) + i);
+			__m128 z = _mm_loadu_ps((plane[2] > 0.0f ? boxes->maxZ : boxes->minZ) + i);
+
+			__m128 d = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])), _mm_mul_ps(y, _mm_set1_ps(plane[1]))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		for (int k = 0; k < 4; k++) {
+			visible[i + k] = !(mask & (1 << k));
+			n_visible += visible[i + k];
+		}
+	}
+#endif
+
+	// remaining boxes (or all of them without SSE)
+	for (; i < boxes->size; i++) {
+		visible[i] = cullBox(frustum, boxes, i);
+		n_visible += visible[i];
+	}
+
+	return n_visible;
+}
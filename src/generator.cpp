@@ -0,0 +1,240 @@
+#include "generator.h"
+#include "profiler.h"
+
+void WorldGenerator::init(int seed) {
+	this->seed = seed;
+	noiseGenerator.init(seed);
+}
+
+void WorldGenerator::placeStructure(Chunk *chunk, const Structure *s, int x, int y, int z) {
+
+	x += s->offset.x;
+	y += s->offset.y;
+	z += s->offset.z;
+
+	// iterate over the structure's data
+	for (int y_s = 0; y_s < s->dim.y; y_s++) {
+		int index = 0;
+		for (int z_s = 0; z_s < s->dim.z; z_s++) {
+			for (int x_s = 0; x_s < s->dim.x; x_s++) {
+
+				BlockType block = static_cast<BlockType>(s->blocks[y_s][index]);
+
+				// blocks outside of the chunk are ignored by setBlock
+				// (the neighbor places them when it is generated, see placeNeighborStructures)
+				if (block != BlockType::AIR) {
+					chunk->setBlock(x + x_s - s->dim.x / 2, y + y_s, z + z_s - s->dim.z / 2, block);
+				}
+				index++;
+			}
+		}
+	}
+}
+
+const Structure *WorldGenerator::pickStructure(StructureRandom *random, BiomeType biome, float continentalness, bool generateTrees) {
+
+	// towers
+	if (biome == BiomeType::PLAINS) {
+		if (!random->hasTower && random->tower.nextInt(0, 10000) < 1) {
+			random->hasTower = 1;
+			return &tower;
+		}
+	}
+
+	// trees
+	if (biome == BiomeType::FOREST && generateTrees) {
+		if (random->tree.nextInt(0, 100) < 1) {
+			return &tree;
+		}
+	}
+
+	// rocks
+	if (biome == BiomeType::DESERT || biome == BiomeType::JUNGLE
+		&& continentalness < 0.3f) {
+		if (random->rock.nextInt(0, 1000) < 1) {
+			return &rock;
+		}
+	}
+
+	return NULL;
+}
+
+void WorldGenerator::placeNeighborStructures(Chunk *chunk, bool generateTrees) {
+
+	ChunkNoise chunkNoise;
+
+	for (int dx = -1; dx <= 1; dx++) {
+		for (int dz = -1; dz <= 1; dz++) {
+			if (dx == 0 && dz == 0) {
+				continue;
+			}
+
+			// replay the structures of the neighbor, with its own noise and random streams
+			int chunkX = chunk->position.x + dx;
+			int chunkZ = chunk->position.y + dz;
+			noiseGenerator.getChunkNoise(chunkX, chunkZ, &chunkNoise);
+			StructureRandom random(seed, chunkX, chunkZ);
+
+			int index = 0;
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				for (int x = 0; x < CHUNK_SIZE; x++) {
+					float continentalness = chunkNoise.layers[NOISE_CONTINENTALNESS][index];
+					BiomeType biome = Chunk::getBiome(chunkNoise.layers[NOISE_TEMPERATURE][index] + 0.5f,
+						chunkNoise.layers[NOISE_HUMIDITY][index] + 0.5f);
+
+					// every column draws, even the ones too far to reach this chunk
+					const Structure *s = pickStructure(&random, biome, continentalness, generateTrees);
+					if (s != NULL) {
+						int value = getTerrainHeight(chunkNoise.layers[NOISE_HEIGHT][index], continentalness);
+						placeStructure(chunk, s, x + dx * CHUNK_SIZE, value, z + dz * CHUNK_SIZE);
+					}
+					index++;
+				}
+			}
+		}
+	}
+}
+
+int WorldGenerator::fitContinentalness(float x) {
+	if (x < 0.3) {
+		return 7.692*x + 17.69;
+	}
+	if (x < 0.4) {
+		return 300*x - 70;
+	}
+	if (x < 1.0) {
+		return 8.33*x + 46.67;
+	}
+}
+
+void WorldGenerator::placeCactus(Chunk *chunk, int x, int y, int z, int height) {
+	for (int i = 0; i < height; i++) {
+		chunk->setBlock(x, y + i, z, BlockType::CACTUS);
+	}
+}
+
+int WorldGenerator::getTerrainHeight(float noise, float continentalness) {
+	// int value = static_cast<int>((noise * 1 + 1) * 13);
+	int value = static_cast<int>((noise + 1) * 13);
+	value += static_cast<int>(fitContinentalness(continentalness));
+	return value;
+}
+
+void WorldGenerator::generateSurface(int x0, int z0, int n, int step, int *heights, Block *surface) {
+
+	std::vector<float> noise(n * n);
+	std::vector<float> temperature(n * n);
+	std::vector<float> humidity(n * n);
+	std::vector<float> continentalness(n * n);
+
+	noiseGenerator.generateGrid(NOISE_HEIGHT, x0, z0, n, n, step, noise.data());
+	noiseGenerator.generateGrid(NOISE_TEMPERATURE, x0, z0, n, n, step, temperature.data());
+	noiseGenerator.generateGrid(NOISE_HUMIDITY, x0, z0, n, n, step, humidity.data());
+	noiseGenerator.generateGrid(NOISE_CONTINENTALNESS, x0, z0, n, n, step, continentalness.data());
+
+	// same rules as generateChunk
+	for (int i = 0; i < n * n; i++) {
+		int value = getTerrainHeight(noise[i], continentalness[i]);
+		BiomeType biome = Chunk::getBiome(temperature[i] + 0.5f, humidity[i] + 0.5f);
+
+		if (value <= 0) {
+			heights[i] = 1;
+			surface[i] = BlockType::SAND;
+		}
+		else {
+			heights[i] = value;
+			surface[i] = (biome == BiomeType::PLAINS || biome == BiomeType::FOREST) ? BlockType::GRASS : BlockType::SAND;
+		}
+	}
+}
+
+void WorldGenerator::generateChunk(Chunk *chunk, bool generateTrees) {
+	PROFILE_ZONE("generateChunk");
+
+	
+
+
+	// sliced from noise tiles shared with the neighboring chunks
+	ChunkNoise chunkNoise;
+	noiseGenerator.getChunkNoise(chunk->position.x, chunk->position.y, &chunkNoise);
+
+	float *noise = chunkNoise.layers[NOISE_HEIGHT];
+	float *temperature = chunkNoise.layers[NOISE_TEMPERATURE];
+	float *humidity = chunkNoise.layers[NOISE_HUMIDITY];
+	float *continentalness = chunkNoise.layers[NOISE_CONTINENTALNESS];
+
+	// decorations only depend on the seed and the chunk position
+	StructureRandom structureRandom(seed, chunk->position.x, chunk->position.y);
+	ChunkRandom cactusRandom(seed, chunk->position.x, chunk->position.y, RANDOM_CACTUS);
+	ChunkRandom herbRandom(seed, chunk->position.x, chunk->position.y, RANDOM_HERB);
+
+	int index = 0;
+
+	// APPLY NOISE
+	for (int z = 0; z < CHUNK_SIZE; z++)
+	{
+		for (int x = 0; x < CHUNK_SIZE; x++)
+		{
+			int value = getTerrainHeight(noise[index], continentalness[index]);
+
+			BiomeType biome = Chunk::getBiome(temperature[index] + 0.5f, humidity[index] + 0.5f);
+
+			switch (biome) {
+			case BiomeType::PLAINS:
+				for (int y = 0; y < value - 1; y++) {
+					chunk->setBlock(x, y, z, BlockType::DIRT);
+				}
+				chunk->setBlock(x, value - 1, z, BlockType::GRASS);
+
+				break;
+			case BiomeType::FOREST:
+				for (int y = 0; y < value - 1; y++) {
+					chunk->setBlock(x, y, z, BlockType::DIRT);
+				}
+				chunk->setBlock(x, value - 1, z, BlockType::GRASS);
+
+				break;
+			case BiomeType::DESERT:
+				for (int y = 0; y < value - 1; y++) {
+					chunk->setBlock(x, y, z, BlockType::STONE);
+				}
+				chunk->setBlock(x, value - 1, z, BlockType::SAND);
+
+				break;
+			case BiomeType::JUNGLE:
+				for (int y = 0; y < value - 1; y++) {
+					chunk->setBlock(x, y, z, BlockType::STONE);
+				}
+				chunk->setBlock(x, value - 1, z, BlockType::SAND);
+
+				// cactus
+				if (cactusRandom.nextInt(0, 80) < 1) {
+					placeCactus(chunk, x, value, z, cactusRandom.nextInt(2, 5));
+				}
+				break;
+			}
+
+			if (value <= 0) {
+				chunk->setBlock(x, 0, z, BlockType::SAND);
+			}
+
+			// surface-level layer
+
+			// herb
+			if (biome == BiomeType::PLAINS || biome == BiomeType::FOREST) {
+				if (herbRandom.nextInt(0, 2) < 1)
+					chunk->setBlockWithCheck(x, value, z, BlockType::HERB);
+			}
+			// towers, trees and rocks
+			const Structure *s = pickStructure(&structureRandom, biome, continentalness[index], generateTrees);
+			if (s != NULL) {
+				placeStructure(chunk, s, x, value, z);
+			}
+
+			index++;
+		}
+	}
+
+	// the blocks of the neighbors' structures: the chunk is the same whatever the generation order
+	placeNeighborStructures(chunk, generateTrees);
+}
@@ -0,0 +1,124 @@
+#include "gpustats.h"
+#include "profiler.h"
+
+#include <cstdio>
+#include <iostream>
+
+static const char *passNames[N_GPU_PASSES] = { "sky", "lod", "chunks", "raycast", "inventory", "overlay" };
+
+static unsigned int queries[GPU_STATS_QUERY_SETS][N_GPU_PASSES];
+static bool issued[GPU_STATS_QUERY_SETS][N_GPU_PASSES]; // began during the frame that used this set
+static int querySet = 0; // set used by the current frame
+static float passTimes[N_GPU_PASSES]; // last measured time of each pass
+
+// sums over the current log period
+static FILE *logFile = NULL;
+static float periodStart = 0.0f;
+static int periodFrames = 0;
+static RenderStats periodSum = {};
+
+void GpuStats::init() {
+
+	glGenQueries(GPU_STATS_QUERY_SETS * N_GPU_PASSES, &queries[0][0]);
+
+	logFile = fopen(GPU_STATS_LOG_FILE, "w");
+	if (logFile == NULL) {
+		std::cout << "Error GpuStats::init(): could not create " << GPU_STATS_LOG_FILE << "\n";
+	}
+}
+
+void GpuStats::beginFrame(float time) {
+
+	// the counters of the last frame are complete
+	last = current;
+	current.drawCalls = 0;
+	current.vertices = 0;
+	current.chunksDrawn = 0;
+	current.sectionsDrawn = 0;
+
+	// this set was used GPU_STATS_QUERY_SETS frames ago: its results are usually ready
+	querySet = (querySet + 1) % GPU_STATS_QUERY_SETS;
+	for (int i = 0; i < N_GPU_PASSES; i++) {
+		if (!issued[querySet][i]) {
+			passTimes[i] = 0.0f;
+			continue;
+		}
+		issued[querySet][i] = false;
+
+		// not ready yet: keep the previous time rather than waiting for the GPU
+		int available = 0;
+		glGetQueryObjectiv(queries[querySet][i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			GLuint64 elapsed = 0; // nanoseconds
+			glGetQueryObjectui64v(queries[querySet][i], GL_QUERY_RESULT, &elapsed);
+			passTimes[i] = elapsed / 1000000.0f;
+		}
+	}
+	for (int i = 0; i < N_GPU_PASSES; i++) {
+		last.passTime[i] = passTimes[i];
+	}
+
+	for (int i = 0; i < N_GPU_PASSES; i++) {
+		periodSum.passTime[i] += last.passTime[i];
+	}
+	periodSum.drawCalls += last.drawCalls;
+	periodSum.vertices += last.vertices;
+	periodSum.chunksDrawn += last.chunksDrawn;
+	periodSum.sectionsDrawn += last.sectionsDrawn;
+	periodFrames++;
+
+	if (time - periodStart >= GPU_STATS_LOG_PERIOD) {
+		writeLog(time);
+		periodStart = time;
+		periodFrames = 0;
+		periodSum = {};
+	}
+}
+
+void GpuStats::beginPass(GpuPass pass) {
+	glBeginQuery(GL_TIME_ELAPSED, queries[querySet][pass]);
+	issued[querySet][pass] = true;
+}
+
+void GpuStats::endPass() {
+	glEndQuery(GL_TIME_ELAPSED);
+}
+
+float GpuStats::getGpuTime() {
+	float total = 0.0f;
+	for (int i = 0; i < N_GPU_PASSES; i++) {
+		total += last.passTime[i];
+	}
+	return total;
+}
+
+const char *GpuStats::getPassName(GpuPass pass) {
+	return passNames[pass];
+}
+
+// one line per period, averaged per frame
+// a GPU time close to the CPU frame time means the GPU is the limit (many vertices: vertex bound, else fill bound)
+void GpuStats::writeLog(float time) {
+
+	if (logFile == NULL || periodFrames == 0) {
+		return;
+	}
+
+	float averageFrame, maxFrame;
+	Profiler::getFrameStats(&averageFrame, &maxFrame);
+
+	fprintf(logFile, "t=%.1fs frames=%d | cpu frame %.2f ms (max %.2f) | gpu ms:", time, periodFrames, averageFrame, maxFrame);
+	float gpuTotal = 0.0f;
+	for (int i = 0; i < N_GPU_PASSES; i++) {
+		fprintf(logFile, " %s %.3f", passNames[i], periodSum.passTime[i] / periodFrames);
+		gpuTotal += periodSum.passTime[i] / periodFrames;
+	}
+	fprintf(logFile, " (total %.3f) | %.1f draws, %.0f vertices, %.1f chunks, %.1f sections per frame | %.1f MB of buffers\n",
+		gpuTotal,
+		(float)periodSum.drawCalls / periodFrames,
+		(double)periodSum.vertices / periodFrames,
+		(float)periodSum.chunksDrawn / periodFrames,
+		(float)periodSum.sectionsDrawn / periodFrames,
+		current.bufferBytes / (1024.0f * 1024.0f));
+	fflush(logFile);
+}
@@ -9,6 +9,8 @@
 
 
 #define N_FACE_DATA 30 // number of floats in a single face data
+#define N_QUAD_DATA 20 // number of floats in a single face quad data (4 corners)
+#define ATLAS_SIZE 6 // number of textures in a column/line in the atlas texture
 
 using Block = unsigned char;
 
@@ -151,24 +153,66 @@ static const float faceData[6][N_FACE_DATA] = {
 	}
 };
 
-static const float crossFaceData[2][N_FACE_DATA] = {
+// same faces as faceData as quads: 4 corners in winding order, drawn as (0, 1, 2) and (2, 3, 0)
+/* order: back, front, left, right, bottom, top */
+static const float faceQuadData[6][N_QUAD_DATA] = {
 	// Back face
 	{
-	-0.5f, -0.5f, -0.5f,  0.0f, 0.0f, // Bottom-left
-	 0.5f,  0.5f, 0.5f,  1.0f, 1.0f, // top-right
-	 0.5f, -0.5f, 0.5f,  1.0f, 0.0f, // bottom-right         
-	 0.5f,  0.5f, 0.5f,  1.0f, 1.0f, // top-right
 	-0.5f, -0.5f, -0.5f,  0.0f, 0.0f, // bottom-left
 	-0.5f,  0.5f, -0.5f,  0.0f, 1.0f, // top-left
+	 0.5f,  0.5f, -0.5f,  1.0f, 1.0f, // top-right
+	 0.5f, -0.5f, -0.5f,  1.0f, 0.0f, // bottom-right
 	},
 	// Front face
 	{
+	 0.5f,  0.5f,  0.5f,  1.0f, 1.0f, // top-right
+	-0.5f,  0.5f,  0.5f,  0.0f, 1.0f, // top-left
 	-0.5f, -0.5f,  0.5f,  0.0f, 0.0f, // bottom-left
-	 0.5f, -0.5f,  -0.5f,  1.0f, 0.0f, // bottom-right
-	 0.5f,  0.5f,  -0.5f,  1.0f, 1.0f, // top-right
-	 0.5f,  0.5f,  -0.5f,  1.0f, 1.0f, // top-right
+	 0.5f, -0.5f,  0.5f,  1.0f, 0.0f, // bottom-right
+	},
+	// Left face
+	{
+	-0.5f, -0.5f, -0.5f,  0.0f, 0.0f, // bottom-left
+	-0.5f, -0.5f,  0.5f,  1.0f, 0.0f, // bottom-right
+	-0.5f,  0.5f,  0.5f,  1.0f, 1.0f, // top-right
+	-0.5f,  0.5f, -0.5f,  0.0f, 1.0f, // top-left
+	},
+	// Right face
+	{
+	 0.5f,  0.5f,  0.5f,  0.0f, 1.0f, // top-left
+	 0.5f, -0.5f,  0.5f,  0.0f, 0.0f, // bottom-left
+	 0.5f, -0.5f, -0.5f,  1.0f, 0.0f, // bottom-right
+	 0.5f,  0.5f, -0.5f,  1.0f, 1.0f, // top-right
+	},
+	// Bottom face
+	{
+	 0.5f, -0.5f,  0.5f,  1.0f, 0.0f, // bottom-left
+	-0.5f, -0.5f,  0.5f,  0.0f, 0.0f, // bottom-right
+	-0.5f, -0.5f, -0.5f,  0.0f, 1.0f, // top-right
+	 0.5f, -0.5f, -0.5f,  1.0f, 1.0f, // top-left
+	},
+	// Top face
+	{
+	-0.5f,  0.5f, -0.5f,  0.0f, 1.0f, // top-left
+	-0.5f,  0.5f,  0.5f,  0.0f, 0.0f, // bottom-left
+	 0.5f,  0.5f,  0.5f,  1.0f, 0.0f, // bottom-right
+	 0.5f,  0.5f, -0.5f,  1.0f, 1.0f, // top-right
+	}
+};
+
+// the two diagonal faces of cross mesh blocks (herbs...), as quads
+static const float crossQuadData[2][N_QUAD_DATA] = {
+	{
+	-0.5f, -0.5f, -0.5f,  0.0f, 0.0f, // bottom-left
+	-0.5f,  0.5f, -0.5f,  0.0f, 1.0f, // top-left
+	 0.5f,  0.5f,  0.5f,  1.0f, 1.0f, // top-right
+	 0.5f, -0.5f,  0.5f,  1.0f, 0.0f, // bottom-right
+	},
+	{
+	 0.5f,  0.5f, -0.5f,  1.0f, 1.0f, // top-right
 	-0.5f,  0.5f,  0.5f,  0.0f, 1.0f, // top-left
 	-0.5f, -0.5f,  0.5f,  0.0f, 0.0f, // bottom-left
+	 0.5f, -0.5f, -0.5f,  1.0f, 0.0f, // bottom-right
 	}
 };
 
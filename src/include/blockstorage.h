@@ -0,0 +1,72 @@
+#ifndef _BLOCK_STORAGE_H_
+#define _BLOCK_STORAGE_H_
+
+#include <cstdint>
+
+#include "block.h"
+
+#define STORAGE_SIZE 4096 // blocks in a storage (a chunk section)
+#define PALETTE_MAX_SIZE 16 // over this, blocks are stored directly (8 bits each)
+
+// blocks of a chunk section, stored as indices into a palette of the block types the section contains
+// indices take 0, 1, 2 or 4 bits depending on the palette size: 0 bits means the whole section is one block
+// with more than PALETTE_MAX_SIZE types, the block types are stored directly (8 bits)
+class BlockStorage {
+
+public:
+
+	BlockStorage();
+
+	~BlockStorage();
+
+	BlockStorage(const BlockStorage&) = delete;
+	BlockStorage& operator=(const BlockStorage&) = delete;
+
+	// fills the storage with a single block (frees the indices)
+	void reset(Block block);
+
+	Block get(int index) const {
+		switch (bits) {
+		case 0:
+			return palette[0];
+		case 8:
+			return reinterpret_cast<const Block*>(data)[index];
+		default:
+			return palette[(data[index >> wordShift] >> ((index & wordMask) * bits)) & indexMask];
+		}
+	}
+
+	// sets a block and returns the block that was there before
+	Block set(int index, Block block);
+
+	// copies n consecutive blocks
+	void getRow(int index, int n, Block *out) const;
+
+	// rebuilds the palette with only the used block types, and the indices with the smallest size
+	void compact();
+
+	// replaces every block (STORAGE_SIZE blocks), with the smallest palette and indices
+	void fill(const Block *blocks);
+
+	int getBits() const { return bits; }
+
+	// bytes used by the indices (the palette itself is not allocated)
+	int getDataSize() const { return bits * STORAGE_SIZE / 8; }
+
+private:
+
+	void setBits(int newBits);
+
+	void updateLookup();
+
+	int bits; // 0, 1, 2, 4 or 8
+	int wordShift, wordMask, indexMask; // to find an index in data (see get)
+
+	uint64_t *data; // indices (or blocks for 8 bits), NULL for 0 bits
+
+	int paletteSize;
+	Block palette[PALETTE_MAX_SIZE];
+	unsigned short counts[PALETTE_MAX_SIZE]; // number of blocks using each palette entry (0: free entry)
+};
+
+#endif /* _BLOCK_STORAGE_H_ */
@@ -5,6 +5,8 @@
 
 #include <vector>
 #include <thread>
+#include <algorithm>
+#include <cstring>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -12,12 +14,27 @@
 
 #include "shader.h"
 #include "block.h"
+#include "blockstorage.h"
 
 #include <FastNoise/FastNoise.h>
 
 #define CHUNK_SIZE 16
 #define HEIGHT_LIMIT 100
 
+#define SECTION_HEIGHT 16 // chunks are split vertically in sections of this height
+#define N_SECTIONS ((HEIGHT_LIMIT + SECTION_HEIGHT - 1) / SECTION_HEIGHT) // the last one can be cut by HEIGHT_LIMIT
+#define SECTION_VOLUME (CHUNK_SIZE * SECTION_HEIGHT * CHUNK_SIZE)
+#define ALL_SECTIONS ((1 << N_SECTIONS) - 1) // section mask with every section of a chunk
+
+// index of a block in a section's blocks (y is relative to the section)
+#define SECTION_INDEX(x, y, z) (((x) * SECTION_HEIGHT + (y)) * CHUNK_SIZE + (z))
+
+static_assert(SECTION_VOLUME == STORAGE_SIZE, "a block storage holds exactly one section");
+static_assert(HEIGHT_LIMIT <= 255, "heightmap values are stored on a byte");
+
+// index of a column in a chunk's heightmap
+#define COLUMN_INDEX(x, z) ((x) + (z) * CHUNK_SIZE)
+
 #define NEIGHBOR_UP 0
 #define NEIGHBOR_DOWN 1
 #define NEIGHBOR_LEFT 2
@@ -27,6 +44,69 @@
 #define BLOCK_PLACED -2
 #define BLOCK_NOT_PLACED -1
 
+// meshing modes (see MeshBuilder)
+#define MESHING_NAIVE 0 // one quad per visible face
+#define MESHING_GREEDY 1 // coplanar faces merged into larger quads
+#define DEFAULT_MESHING MESHING_GREEDY
+
+// packed chunk vertex: 2 unsigned ints (8 bytes), unpacked in chunk_v.vert
+/* word 0: x + 0.5 (5 bits), y + 0.5 (9 bits), z + 0.5 (5 bits), face (3 bits), ambient occlusion level (2 bits) */
+/* word 1: u (9 bits), v (9 bits), atlas tile (6 bits) */
+#define CHUNK_VERTEX_SIZE 2 // number of unsigned ints in a chunk vertex
+
+class Chunk;
+class MeshUploader;
+
+// SECTION_HEIGHT high slice of a chunk, with its own mesh
+struct ChunkSection {
+	BlockStorage blocks; // [x][y][z] (see SECTION_INDEX), palette compressed
+	int n_blocks; // blocks that are not air
+	int n_solid; // solid blocks (see Chunk::isSolid)
+
+	int meshOffset, meshSize; // vertices allocated for the mesh in the mesh arena (meshSize is 0 if none)
+	int n_meshVertices; // 4 per quad
+	int meshRevision; // incremented each time a mesh build starts, to drop outdated meshes
+};
+
+// immutable copy of a chunk's blocks and of the border blocks of its neighbors
+// the mesh of the sections in sectionMask can be built from it on any thread while the chunk keeps changing
+struct ChunkSnapshot {
+	Chunk *chunk; // chunk the mesh is built for
+	int sectionMask; // sections to build
+	int revision[N_SECTIONS]; // value of each section's meshRevision when the snapshot was taken
+	bool hidden[N_SECTIONS]; // sections with nothing to draw (only their rows are not copied)
+	int meshingMode;
+	unsigned char heightmap[CHUNK_SIZE * CHUNK_SIZE]; // the chunk's heightmap (see Chunk::heightmap)
+	int maxHeight;
+	Block blocks[CHUNK_SIZE + 2][HEIGHT_LIMIT][CHUNK_SIZE + 2]; // one block of border on x and z
+
+	// x and z can go from -1 to CHUNK_SIZE (neighbor borders)
+	Block get(int x, int y, int z) const {
+		if (y < 0 || y >= HEIGHT_LIMIT) {
+			return BlockType::AIR;
+		}
+		return blocks[x + 1][y][z + 1];
+	}
+};
+
+// vertex data built from a snapshot (see MeshBuilder), waiting to be uploaded on the main thread
+// the sections are stored one after the other in a single buffer
+struct ChunkMesh {
+	Chunk *chunk;
+	int sectionMask;
+	int revision[N_SECTIONS];
+	int sectionStart[N_SECTIONS + 1]; // first vertex of each section in data (the last one is the vertex count)
+	std::vector<unsigned int> data; // packed vertices (see CHUNK_VERTEX_SIZE)
+
+	const unsigned int *getSection(int i) const {
+		return data.data() + sectionStart[i] * CHUNK_VERTEX_SIZE;
+	}
+
+	int getSectionVertices(int i) const {
+		return sectionStart[i + 1] - sectionStart[i];
+	}
+};
+
 enum BiomeType {
 	PLAINS,
 	FOREST,
@@ -38,28 +118,46 @@ class Chunk {
 
 public:
 
-	/* for OpenGL */
-	unsigned int VBO, VAO;
-	float* meshData;
-	int meshData_size;
-	int n_meshTriangles;
+	ChunkSection sections[N_SECTIONS]; // from bottom to top
+
+	// for each column (see COLUMN_INDEX): y of the highest non-air block + 1 (0 if the column is empty)
+	// everything above is air: meshing and raycasts can skip it
+	unsigned char heightmap[CHUNK_SIZE * CHUNK_SIZE];
+	int maxHeight; // highest value of the heightmap
+
+	int meshJobs; // meshes of this chunk still being built by the workers
 
 	glm::ivec2 position; // x, z
-	bool isBuilt; // has the chunk been generated?
+	bool isBuilt; // has the chunk mesh been built?
+	bool isGenerated; // have the chunk's blocks been generated?
+	bool isGenerating; // is a worker currently generating the chunk's blocks?
 	bool used; // has the chunk been modified?
 	bool structuresPlaced;
 
 	Chunk *neighbors[4]; // up, down, left, right
 
+	inline static int meshingMode = DEFAULT_MESHING; // shared by all chunks, see MESHING_ defines
+
+	inline static MeshUploader *uploader = NULL; // sends the meshes to the mesh arena, set by the chunk manager
+
 	Chunk() {
+		// meshes are not reset by resetBlockData: they are kept when the chunk is recycled by the pool
+		for (int i = 0; i < N_SECTIONS; i++) {
+			sections[i].meshOffset = 0;
+			sections[i].meshSize = 0;
+			sections[i].n_meshVertices = 0;
+			sections[i].meshRevision = 0;
+		}
+		meshJobs = 0;
 		resetBlockData();
-		isBuilt = false;
 	}
 
 	// initiate block data to empty
 	void resetBlockData() {
-		memset(blockData, BlockType::AIR, CHUNK_SIZE * HEIGHT_LIMIT * CHUNK_SIZE);
+		clearBlocks();
 		isBuilt = false;
+		isGenerated = false;
+		isGenerating = false;
 		used = false;
 		structuresPlaced = false;
 		neighbors[NEIGHBOR_UP] = nullptr;
@@ -68,6 +166,17 @@ public:
 		neighbors[NEIGHBOR_RIGHT] = nullptr;
 	}
 
+	// empties the sections and the heightmap only (the flags and neighbors belong to the main thread)
+	void clearBlocks() {
+		for (int i = 0; i < N_SECTIONS; i++) {
+			sections[i].blocks.reset(BlockType::AIR);
+			sections[i].n_blocks = 0;
+			sections[i].n_solid = 0;
+		}
+		memset(heightmap, 0, sizeof(heightmap));
+		maxHeight = 0;
+	}
+
 	// fill with test chunk data
 	void fillChunk() {
 
@@ -121,17 +230,145 @@ public:
 		if (x < 0 || y < 0 || z < 0 || x > CHUNK_SIZE - 1 || y > HEIGHT_LIMIT - 1 || z > CHUNK_SIZE - 1)
 			return;
 
-		blockData[x][y][z] = type;
+		ChunkSection *section = &sections[y / SECTION_HEIGHT];
+
+		Block previous = section->blocks.set(SECTION_INDEX(x, y % SECTION_HEIGHT, z), type);
+		if (previous == type) {
+			return;
+		}
+
+		section->n_blocks += (type != BlockType::AIR) - (previous != BlockType::AIR);
+		section->n_solid += isSolid(type) - isSolid(previous);
+
+		// an emptied section doesn't need its indices anymore
+		if (section->n_blocks == 0) {
+			section->blocks.reset(BlockType::AIR);
+		}
+
+		// keep the heightmap up to date: it only needs a scan when the top block of a column is removed
+		unsigned char *height = &heightmap[COLUMN_INDEX(x, z)];
+		if (type != BlockType::AIR) {
+			if (y >= *height) {
+				*height = y + 1;
+				maxHeight = std::max(maxHeight, y + 1);
+			}
+		}
+		else if (y == *height - 1) {
+			int h = y;
+			while (h > 0 && getBlock(x, h - 1, z) == BlockType::AIR) {
+				h--;
+			}
+			*height = h;
+			if (y + 1 == maxHeight) {
+				maxHeight = *std::max_element(heightmap, heightmap + CHUNK_SIZE * CHUNK_SIZE);
+			}
+		}
+	}
+
+	// rebuilds the heightmap from the blocks (after they were replaced by whole sections)
+	void calculateHeightmap() {
+		maxHeight = 0;
+		for (int x = 0; x < CHUNK_SIZE; x++) {
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				int h = HEIGHT_LIMIT;
+				while (h > 0 && getBlock(x, h - 1, z) == BlockType::AIR) {
+					h--;
+				}
+				heightmap[COLUMN_INDEX(x, z)] = h;
+				maxHeight = std::max(maxHeight, h);
+			}
+		}
+	}
+
+	// y of the highest non-air block of a column + 1 (0 if the column is empty)
+	int getHeight(int x, int z) {
+		return heightmap[COLUMN_INDEX(x, z)];
+	}
+
+	// replaces all the blocks of a section (STORAGE_SIZE blocks, in SECTION_INDEX order)
+	// the heightmap is not updated: call calculateHeightmap() once every section is set
+	void setSectionBlocks(int section, const Block *blocks) {
+
+		ChunkSection *s = &sections[section];
+		s->blocks.fill(blocks);
+
+		s->n_blocks = 0;
+		s->n_solid = 0;
+		for (int i = 0; i < STORAGE_SIZE; i++) {
+			s->n_blocks += blocks[i] != BlockType::AIR;
+			s->n_solid += isSolid(blocks[i]);
+		}
 	}
 
 	// places a block if there isn't already one there
 	void setBlockWithCheck(int x, int y, int z, BlockType type) {
 
-		if (blockData[x][y][z] == BlockType::AIR) {
+		if (getBlock(x, y, z) == BlockType::AIR) {
 			setBlock(x, y, z, type);
 		}
 	}
 
+	// shrinks the palette and indices of every section to what they contain
+	// (sections filled with a single type of block, like air or stone deep underground, then take no index memory)
+	void compactSections() {
+		for (int i = 0; i < N_SECTIONS; i++) {
+			sections[i].blocks.compact();
+		}
+	}
+
+	// bytes used by the block indices of all the sections
+	int getBlockMemory() {
+		int size = 0;
+		for (int i = 0; i < N_SECTIONS; i++) {
+			size += sections[i].blocks.getDataSize();
+		}
+		return size;
+	}
+
+	// number of rows of a section (only the top one can be cut by HEIGHT_LIMIT)
+	static int getSectionHeight(int section) {
+		return std::min(SECTION_HEIGHT, HEIGHT_LIMIT - section * SECTION_HEIGHT);
+	}
+
+	// is every block of the section solid?
+	int isSectionFull(int section) {
+		return sections[section].n_solid == CHUNK_SIZE * getSectionHeight(section) * CHUNK_SIZE;
+	}
+
+	// a section has nothing to draw if it is empty, or full and surrounded by full sections
+	// (the bottom of the world and missing neighbors count as open, like in the MeshBuilder face checks)
+	int isSectionHidden(int section) {
+
+		if (sections[section].n_blocks == 0) {
+			return 1;
+		}
+		if (!isSectionFull(section)
+			|| section == 0 || !isSectionFull(section - 1)
+			|| section == N_SECTIONS - 1 || !isSectionFull(section + 1)) {
+			return 0;
+		}
+		for (int i = 0; i < 4; i++) {
+			if (neighbors[i] == nullptr || !neighbors[i]->isSectionFull(section)) {
+				return 0;
+			}
+		}
+		return 1;
+	}
+
+	// mask of the sections whose mesh depends on the block at this height
+	// (its section, and the one above or below if the block is on their border)
+	static int getSectionsAround(int y) {
+		int section = y / SECTION_HEIGHT;
+		int mask = 1 << section;
+		if (y % SECTION_HEIGHT == 0 && section > 0) {
+			mask |= 1 << (section - 1);
+		}
+		if (y % SECTION_HEIGHT == SECTION_HEIGHT - 1 && section < N_SECTIONS - 1) {
+			mask |= 1 << (section + 1);
+		}
+		return mask;
+	}
+
 	// try to place a block in the chunk
 	// if the coords are out of bounds, returns a NEIGHBOR index for the world class to process
 	int setBlockWithNeighbors(int x, int y, int z, BlockType type, int *xChunk, int *zChunk) {
@@ -210,9 +447,10 @@ public:
 		}
 
 		currentChunk->setBlock(x, y, z, type);
+		currentChunk->used = true; // chunk has now been modified
 
 		if (recalculateMeshes) {
-			recalculateNeighboringMeshes(x, z);
+			currentChunk->recalculateNeighboringMeshes(x, y, z);
 		}
 
 		return BLOCK_PLACED;
@@ -224,21 +462,29 @@ public:
 		if (x < 0 || y < 0 || z < 0 || x > CHUNK_SIZE - 1 || y > HEIGHT_LIMIT - 1 || z > CHUNK_SIZE - 1)
 			return;
 
-		blockData[x][y][z] = BlockType::AIR;
+		setBlock(x, y, z, BlockType::AIR);
 		used = true; // chunk has now been modified
 
 		if (recalculateMeshes) {
-			recalculateNeighboringMeshes(x, z);
+			recalculateNeighboringMeshes(x, y, z);
 		}
 	}
 
 	Block getBlock(int x, int y, int z) {
 		if (x >= 0 && x < CHUNK_SIZE && y >= 0 && y < HEIGHT_LIMIT && z >= 0 && z < CHUNK_SIZE) {
-			return blockData[x][y][z];
+			return sections[y / SECTION_HEIGHT].blocks.get(SECTION_INDEX(x, y % SECTION_HEIGHT, z));
 		}
 		else return BlockType::AIR;
 	}
 
+	// is there a solid block here? (the air above the surface is answered by the heightmap alone)
+	int isSolidBlock(int x, int y, int z) {
+		if (x < 0 || y < 0 || z < 0 || x > CHUNK_SIZE - 1 || z > CHUNK_SIZE - 1 || y >= heightmap[COLUMN_INDEX(x, z)]) {
+			return 0;
+		}
+		return isSolid(getBlock(x, y, z));
+	}
+
 	Block getBlockWithNeighbors(int x, int y, int z) {
 
 		Chunk *currentChunk = this;
@@ -248,7 +494,7 @@ public:
 		}
 
 		if (x >= 0 && x < CHUNK_SIZE && y >= 0 && y < HEIGHT_LIMIT && z >= 0 && z < CHUNK_SIZE) {
-			return blockData[x][y][z];
+			return getBlock(x, y, z);
 		}
 		
 		// not valid: need to change chunks
@@ -284,122 +530,44 @@ public:
 		return currentChunk->getBlock(x, y, z);
 	}
 
-	void recalculateNeighboringMeshes(int x, int z) {
-		calculateMesh();
+	// only rebuilds the sections around the block
+	void recalculateNeighboringMeshes(int x, int y, int z) {
+		int sectionMask = getSectionsAround(y);
+		calculateMesh(sectionMask);
 		// calculate the neighbouring chunk's meshes too
 		if (x == CHUNK_SIZE - 1) {
 			if (neighbors[NEIGHBOR_RIGHT] != NULL) {
-				neighbors[NEIGHBOR_RIGHT]->calculateMesh();
+				neighbors[NEIGHBOR_RIGHT]->calculateMesh(sectionMask);
 			}
 		}
 		if (x == 0) {
 			if (neighbors[NEIGHBOR_LEFT] != NULL) {
-				neighbors[NEIGHBOR_LEFT]->calculateMesh();
+				neighbors[NEIGHBOR_LEFT]->calculateMesh(sectionMask);
 			}
 		}
 		if (z == CHUNK_SIZE - 1) {
 			if (neighbors[NEIGHBOR_UP] != NULL) {
-				neighbors[NEIGHBOR_UP]->calculateMesh();
+				neighbors[NEIGHBOR_UP]->calculateMesh(sectionMask);
 			}
 		}
 		if (z == 0) {
 			if (neighbors[NEIGHBOR_DOWN] != NULL) {
-				neighbors[NEIGHBOR_DOWN]->calculateMesh();
+				neighbors[NEIGHBOR_DOWN]->calculateMesh(sectionMask);
 			}
 		}
-	}
-
-	void render(Shader* shader) {
-
-		glm::mat4 model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
-		model = glm::translate(model, glm::vec3(position.x * CHUNK_SIZE, 0.0f, position.y * CHUNK_SIZE));
-		shader->setMat4("model", model);
-
-		glBindVertexArray(VAO);
-
-		glDrawArrays(GL_TRIANGLES, 0, n_meshTriangles);
-	}
-
-	/* check if a face has no solid block in front of it */
-	int checkFaceFree(int x, int y, int z, int face) {
-
-		/* order: back, front, left, right, bottom, top */
-		switch (face) {
-
-		case 0: // back
-			if (z - 1 < 0) {
-				if (neighbors[NEIGHBOR_DOWN] != NULL) {
-					if (isSolid(neighbors[NEIGHBOR_DOWN]->getBlock(x, y, 15))) {
-						return 0;
-					}
-				}
-				else return 1;
-			}
-			if (isSolid(getBlock(x, y, z - 1))) {
-				return 0;
-			}
-			break;
-		case 1: // front
-			if (z + 1 == CHUNK_SIZE) {
-				if (neighbors[NEIGHBOR_UP] != NULL) {
-					if (isSolid(neighbors[NEIGHBOR_UP]->getBlock(x, y, 0))) {
-						return 0;
-					}
-				}
-				else return 1;
-			}
-			if (isSolid(getBlock(x, y, z + 1))) {
-				return 0;
-			}
-			break;
-		case 2: // left
-			if (x - 1 < 0) {
-				if (neighbors[NEIGHBOR_LEFT] != NULL) {
-					if (isSolid(neighbors[NEIGHBOR_LEFT]->getBlock(15, y, z))) {
-						return 0;
-					}
+		// a block in a corner also changes the ambient occlusion of the diagonal chunk
+		if ((x == 0 || x == CHUNK_SIZE - 1) && (z == 0 || z == CHUNK_SIZE - 1)) {
+			Chunk *side = neighbors[x == 0 ? NEIGHBOR_LEFT : NEIGHBOR_RIGHT];
+			if (side != NULL) {
+				Chunk *diagonal = side->neighbors[z == 0 ? NEIGHBOR_DOWN : NEIGHBOR_UP];
+				if (diagonal != NULL) {
+					diagonal->calculateMesh(sectionMask);
 				}
-				else return 1;
-			}
-			if (isSolid(getBlock(x - 1, y, z))) {
-				return 0;
-			}
-			break;
-		case 3: // right
-			if (x + 1 == CHUNK_SIZE) {
-				if (neighbors[NEIGHBOR_RIGHT] != NULL) {
-					if (isSolid(neighbors[NEIGHBOR_RIGHT]->getBlock(0, y, z))) {
-						return 0;
-					}
-				}
-				else return 1;
-			}
-			if (isSolid(getBlock(x + 1, y, z))) {
-				return 0;
-			}
-			break;
-		case 4: // bottom
-			if (y - 1 < 0) {
-				return 1;
-			}
-			if (isSolid(getBlock(x, y - 1, z))) {
-				return 0;
-			}
-			break;
-		case 5: // top
-			if (y + 1 == HEIGHT_LIMIT) {
-				return 1;
-			}
-			if (isSolid(getBlock(x, y + 1, z))) {
-				return 0;
 			}
-			break;
 		}
-
-		return 1;
 	}
 
-	BiomeType getBiome(float temperature, float humidity) {
+	static BiomeType getBiome(float temperature, float humidity) {
 		if (temperature < 0.5f) {
 			if (humidity < 0.5f) {
 				return BiomeType::PLAINS;
@@ -424,154 +592,64 @@ public:
 		}*/
 	}
 
-	// calculates the ambient occlusion value (4 possible values) for a vertex
-	float calculateAO(glm::vec3 vert, glm::ivec3 blockPos) {
-		// calculate "direction" of block center to vertex position
-		glm::ivec3 v = glm::ivec3(vert.x * 2, vert.y * 2, vert.z * 2);
-
-		glm::ivec3 cornerPos = blockPos + v;
-		glm::ivec3 sidePos1 = blockPos + glm::ivec3(v.x, v.y, 0);
-		glm::ivec3 sidePos2 = blockPos + glm::ivec3(0, v.y, v.z);
-
-		int side1 = isSolid(getBlockWithNeighbors(sidePos1.x, sidePos1.y, sidePos1.z));
-		int side2 = isSolid(getBlockWithNeighbors(sidePos2.x, sidePos2.y, sidePos2.z));
-		int corner = isSolid(getBlockWithNeighbors(cornerPos.x, cornerPos.y, cornerPos.z));
-		
-		if (side1 && side2) {
-			return 0.7f; // 0
-		}
-		else if ((side1 && corner) || (side2 && corner)) {
-			return 0.8f; // 1
-		}
-		else if (side1 || corner || side2) {
-			return 0.9f; // 2
-		}
-		else return 1.0f; // 3
-	}
-
-	void calculateMesh() {
-
-		/* DATA IS: 3 float (pos), 2 float (texcoord), 2 float (tex offset) */
-		/* OPTIMIZE: MAKE LAST FLOATS INT? */
-
-		float *data;
-
-		// N_FACE_DATA + 1 is because ambient occlusion (one float) was added
-		data = (float*)malloc(CHUNK_SIZE * CHUNK_SIZE * HEIGHT_LIMIT * (N_FACE_DATA + 1) * sizeof(float));
-		if (data == NULL) {
-			std::cout << "Error calculateMesh(): could not reserve memory\n";
+	// copies the blocks needed to build the mesh of the sections in sectionMask (this chunk and the borders of its neighbors)
+	// must be called from the main thread, the snapshot can then be meshed on any thread
+	void takeSnapshot(ChunkSnapshot *snapshot, int sectionMask) {
+
+		snapshot->chunk = this;
+		snapshot->sectionMask = sectionMask;
+		snapshot->meshingMode = meshingMode;
+		memcpy(snapshot->heightmap, heightmap, sizeof(heightmap));
+		snapshot->maxHeight = maxHeight;
+
+		// only the rows of the sections to build (and the rows right around them) are needed
+		int yMin = HEIGHT_LIMIT;
+		int yMax = -1;
+		for (int i = 0; i < N_SECTIONS; i++) {
+			if (!(sectionMask & (1 << i))) {
+				continue;
+			}
+			snapshot->revision[i] = ++sections[i].meshRevision; // older meshes still being built are now outdated
+			snapshot->hidden[i] = isSectionHidden(i);
+			if (!snapshot->hidden[i]) {
+				yMin = std::min(yMin, i * SECTION_HEIGHT - 1);
+				yMax = std::max(yMax, i * SECTION_HEIGHT + getSectionHeight(i));
+			}
 		}
+		yMin = std::max(yMin, 0);
+		yMax = std::min(yMax, HEIGHT_LIMIT - 1);
 
-		n_meshTriangles = 0;
-		int dSize = 0;
-
-		float start_time = static_cast<float>(glfwGetTime());
-
-		for (int x = 0; x < CHUNK_SIZE; x++) {
-			for (int y = 0; y < HEIGHT_LIMIT; y++) {
-				for (int z = 0; z < CHUNK_SIZE; z++) {
-					
-					// for each block
-					Block block = getBlock(x, y, z);
-					if (block != BlockType::AIR) {
-
-						// calculate local position of the block (in the chunk)
-						glm::vec3 blockPos = glm::vec3(x, y, z);
-
-						/* for each face */
-						/* order: back, front, left, right, bottom, top */
-						int end = blockMesh(block) ? 6 : 2;
-						for (int i = 0; i < end; i++) {
-
-							if (blockMesh(block)) {
-								// block mesh
-								if (checkFaceFree(blockPos.x, blockPos.y, blockPos.z, i)) {
-									for (int j = 0; j < N_FACE_DATA; j += 5) {
-
-										// position
-										data[dSize++] = (faceData[i][j] + blockPos.x);
-										data[dSize++] = (faceData[i][j + 1] + blockPos.y);
-										data[dSize++] = (faceData[i][j + 2] + blockPos.z);
-										n_meshTriangles++;
-										// texture uv
-										data[dSize++] = (faceData[i][j + 3]);
-										data[dSize++] = (faceData[i][j + 4]);
-										// texture offset
-										data[dSize++] = (faceTexture[block][i].x);
-										data[dSize++] = (faceTexture[block][i].y);
-										// ambient occlusion
-										// get the point 
-										data[dSize++] = calculateAO(glm::vec3(faceData[i][j],
-											faceData[i][j + 1],
-											faceData[i][j + 2]),
-											blockPos);
-									}
-								}
-							}
-							else {
-								// cross mesh
-								for (int j = 0; j < N_FACE_DATA; j += 5) {
-
-									// position
-									data[dSize++] = (crossFaceData[i][j] + blockPos.x);
-									data[dSize++] = (crossFaceData[i][j + 1] + blockPos.y);
-									data[dSize++] = (crossFaceData[i][j + 2] + blockPos.z);
-									n_meshTriangles++;
-									// texture uv
-									data[dSize++] = (crossFaceData[i][j + 3]);
-									data[dSize++] = (crossFaceData[i][j + 4]);
-									// texture offset
-									data[dSize++] = (faceTexture[block][i].x);
-									data[dSize++] = (faceTexture[block][i].y);
-									// ambient occlusion (always 1.0 for cross meshes)
-									data[dSize++] = 1.0;
-								}
-							}
-						}
+		for (int x = -1; x <= CHUNK_SIZE; x++) {
+			for (int y = yMin; y <= yMax; y++) {
+				if (x >= 0 && x < CHUNK_SIZE) {
+					// inside the chunk: copy the whole row, then the two neighbor borders
+					sections[y / SECTION_HEIGHT].blocks.getRow(SECTION_INDEX(x, y % SECTION_HEIGHT, 0), CHUNK_SIZE, &snapshot->blocks[x + 1][y][1]);
+					snapshot->blocks[x + 1][y][0] = getBlockWithNeighbors(x, y, -1);
+					snapshot->blocks[x + 1][y][CHUNK_SIZE + 1] = getBlockWithNeighbors(x, y, CHUNK_SIZE);
+				}
+				else {
+					for (int z = -1; z <= CHUNK_SIZE; z++) {
+						snapshot->blocks[x + 1][y][z + 1] = getBlockWithNeighbors(x, y, z);
 					}
-
 				}
 			}
 		}
+	}
 
-		// now translate data for OpenGL
-
-		int dataSize = dSize;
-		data = (float*)realloc(data, dSize * sizeof(float));
-
-		/*
-		std::cout << "(" << static_cast<float>(glfwGetTime()) - start_time << ") ";
-		std::cout << "mesh built | dataSize = " << dataSize << " - ";
-		std::cout << "n_meshTriangles = " << n_meshTriangles << "\n";
-		*/
-
-
-		// make opengl data
-
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-
-		glBindVertexArray(VAO);
-
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, dataSize * sizeof(float), data, GL_STATIC_DRAW);
-
+	int getMeshVertices() {
+		int n_vertices = 0;
+		for (int i = 0; i < N_SECTIONS; i++) {
+			n_vertices += sections[i].n_meshVertices;
+		}
+		return n_vertices;
+	}
 
-		// position attribute
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(0);
-		// texture coord attribute
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(1);
-		// texture offset attribute
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(5 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		// ambient occlusion attribute
-		glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(7 * sizeof(float)));
-		glEnableVertexAttribArray(3);
+	// builds and uploads the mesh of these sections right away (used when a block is placed or broken)
+	// uses the calling thread's MeshBuilder, must be called from the main thread (see chunk.cpp)
+	void calculateMesh(int sectionMask = ALL_SECTIONS);
 
-		isBuilt = true;
-	}
+	// frees the mesh before the chunk is recycled
+	void releaseMesh();
 
 	void removeNeighbors() {
 		// reset neighbors to avoid pointers referencing nothing
@@ -588,26 +666,26 @@ public:
 			neighbors[NEIGHBOR_RIGHT]->neighbors[NEIGHBOR_LEFT] = nullptr;
 		}
 
-		// free(this);
+		neighbors[NEIGHBOR_UP] = nullptr;
+		neighbors[NEIGHBOR_DOWN] = nullptr;
+		neighbors[NEIGHBOR_LEFT] = nullptr;
+		neighbors[NEIGHBOR_RIGHT] = nullptr;
 	}
 
-	int isSolid(Block block) {
+	static int isSolid(Block block) {
 		if (block == BlockType::AIR || block == BlockType::HERB) {
 			return 0;
 		}
 		else return 1;
 	}
 
-	int blockMesh(Block block) {
+	static int blockMesh(Block block) {
 		if (block == BlockType::HERB) {
 			return 0;
 		}
 		else return 1;
 	}
 
-private:
-	Block blockData[CHUNK_SIZE][HEIGHT_LIMIT][CHUNK_SIZE];
-
 };
 
 #endif /* _CHUNK_H_ */
\ No newline at end of file
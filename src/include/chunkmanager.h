@@ -7,12 +7,32 @@
 #include "chunk.h"
 #include "renderer.h"
 #include "camera.h"
+#include "threadpool.h"
+#include "chunkmap.h"
+#include "chunkpool.h"
+#include "meshuploader.h"
+#include "frustum.h"
+#include "region.h"
+#include "lod.h"
 
 #include <vector>
 #include <algorithm>
 #include <thread>
+#include <mutex>
+#include <shared_mutex>
+
+#define MAX_GEN_JOBS 32 // max number of chunks being generated by the workers at the same time
+#define MAX_MESH_JOBS 64 // max number of chunk meshes being built by the workers at the same time
+#define MESH_UPLOAD_BUDGET 0.004 // time (in seconds) that can be spent uploading meshes each frame
 
 class World;
+struct GeneratedChunk;
+
+// chunk section waiting for the frustum test
+struct CulledSection {
+	Chunk *chunk;
+	int section;
+};
 
 class ChunkManager {
 
@@ -20,10 +40,10 @@ public:
 
 	World *world;
 
-	std::vector<Chunk*> loadedChunks; // keep references to all the loaded chunks
-	// std::vector<Chunk*> loadedChunks;
+	ChunkMap loadedChunks; // all the loaded chunks, indexed by chunk position
 	std::vector<Chunk*> toUnloadChunks;
 	std::vector<Chunk*> unbuiltChunks;
+	std::vector<Chunk*> ungeneratedChunks; // requested chunks waiting to be sent to the workers
 
 	glm::ivec2 *toLoadPositions; // chunk positions to load
 	int toLoadPositions_size = 0;
@@ -31,32 +51,108 @@ public:
 	Chunk **visibleChunks;
 	int visibleChunks_size;
 
+	bool reportMeshStats = false; // print mesh stats once all chunks are built
+
+	MeshUploader meshUploader; // sends the chunk meshes to the GPU, owns the mesh arena
+
+	RegionStore regionStore; // modified chunks, saved when they are unloaded
+
+	LodManager lodManager; // terrain past the render distance
+
+	// locked (exclusively) by the main thread while it changes blocks or the loaded chunks,
+	// shared by the queries of other threads (see World::queryRays)
+	std::shared_mutex chunksMutex;
+
+	int sectionsDrawn = 0; // chunk sections drawn last frame
+	int sectionsCulled = 0; // chunk sections with a mesh skipped last frame (outside of the camera's view)
+
 	ChunkManager();
 
+	~ChunkManager();
+
 	void init();
 
 	void update(Camera *camera, int playerMoved);
 
 	float getChunkDistanceFromCamera(Chunk *chunk, Camera *camera);
 
-	// builds one unbuilt chunk (the closest one)
+	// sends the closest ungenerated chunks to the workers
+	void generateRequestedChunks(Camera *camera);
+
+	// queues the generation of the chunk's blocks on the workers
+	void submitGenerationJob(Chunk *chunk, float priority);
+
+	// adds the chunks generated by the workers to the world
+	void finishGeneratedChunks();
+
+	// links a chunk with its generated neighbors
+	void linkNeighbors(Chunk *chunk);
+
+	// sends the closest unbuilt chunks to the workers and uploads the meshes they built
 	void buildUnbuiltChunks(Camera *camera);
 
+	// snapshots the chunk and queues its mesh build on the workers
+	void submitMeshJob(Chunk *chunk, float priority);
+
+	// uploads the meshes built by the workers, within MESH_UPLOAD_BUDGET
+	void uploadBuiltMeshes();
+
 	// request chunks into visible chunks
 	Chunk** requestChunks();
 
 	// calculates in which chunk the player currently is
 	glm::ivec2 getChunkPosition(glm::vec3 *position);
 
-	// WARNING: CURRENTLY NOT FREEING ANYTHING
+	// unloads the chunks that are out of range and gives them back to the pool (modified ones are saved first)
 	void checkFarChunks(Camera *camera);
 
+	// queues a job writing the saved chunks to their region files
+	void submitFlushJob();
+
+	// starts reading the saved chunks the player is moving towards, before they are requested
+	void prefetchSavedChunks(Camera *camera);
+
+	// saves every loaded modified chunk and waits for them to be written (when quitting)
+	void saveModifiedChunks();
+
 	// better as a camera member class?
 	void requestChunkPositions(Camera *camera);
 
-	void renderChunks(Shader* shader);
+	// draws all the chunks in the camera's view at once from the mesh arena
+	void renderChunks(Shader* shader, Camera *camera);
+
+	// queues every loaded chunk for a rebuild (used when the meshing mode changes)
+	void rebuildAllChunks();
+
+	// prints the vertex count and mesh arena memory of all built chunks
+	void printMeshStats();
 
 	Chunk *getPlayerChunk(Camera *camera);
+
+	// returns the loaded chunk at this chunk position (or NULL)
+	Chunk *getLoadedChunk(int x, int z);
+
+private:
+
+	std::mutex generatedChunksMutex;
+	std::vector<GeneratedChunk*> generatedChunks; // chunks generated by the workers, waiting to be added
+	int genJobsInFlight = 0;
+
+	std::mutex builtMeshesMutex;
+	std::vector<ChunkMesh*> builtMeshes; // meshes built by the workers, waiting to be uploaded
+	int meshJobsInFlight = 0; // submitted meshes that have not been uploaded (or dropped) yet
+
+	ChunkPool chunkPool;
+
+	glm::ivec2 lastPlayerChunk = glm::ivec2(0, 0); // to know in which direction the player is moving
+	float lastRegionReport = 0.0f; // time of the last region load latency report
+
+	// frustum culling data, kept between frames to avoid reallocating it
+	FrustumBoxes cullBoxes = {};
+	std::vector<CulledSection> cullSections; // section of each box
+	std::vector<unsigned char> cullVisible;
+
+	ThreadPool workers; // declared last: stopped before the data its jobs use is destroyed
 };
 
 #endif /* _CHUNK_MANAGER_H_ */
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef _CHUNK_MAP_H_
+#define _CHUNK_MAP_H_
+
+#include <glm/glm.hpp>
+
+class Chunk;
+
+#define CHUNK_MAP_MIN_CAPACITY 256 // must be a power of two
+
+// chunks indexed by their chunk position (open addressing, linear probing)
+// lookup, insert and erase are O(1) on average
+class ChunkMap {
+
+public:
+
+	ChunkMap();
+
+	~ChunkMap();
+
+	// returns the chunk at this chunk position (or NULL)
+	Chunk *find(int x, int z) const;
+
+	// adds a chunk, keyed on its position (replaces the chunk already at this position)
+	void insert(Chunk *chunk);
+
+	// removes the chunk at this chunk position, if any
+	void erase(int x, int z);
+
+	void clear();
+
+	int size() const {
+		return count;
+	}
+
+	// iteration: for (int i = 0; i < map.capacity(); i++) if (map.at(i) != NULL) ...
+	// do not insert or erase while iterating
+	int capacity() const {
+		return slots_size;
+	}
+
+	Chunk *at(int slot) const {
+		return slots[slot].chunk;
+	}
+
+private:
+
+	struct Slot {
+		glm::ivec2 key;
+		Chunk *chunk; // NULL if the slot is empty
+	};
+
+	Slot *slots;
+	int slots_size;
+	int count;
+
+	// index of the slot holding this position, or of the empty slot ending its probe sequence
+	int findSlot(int x, int z) const;
+
+	void resize(int new_size);
+};
+
+#endif /* _CHUNK_MAP_H_ */
@@ -0,0 +1,37 @@
+#ifndef _CHUNK_POOL_H_
+#define _CHUNK_POOL_H_
+
+#include <vector>
+
+class Chunk;
+
+#define CHUNK_POOL_MAX_FREE 128 // unloaded chunks kept for reuse, the others are deleted
+
+// recycles unloaded chunks for the newly requested ones
+// must only be used from the main thread (meshes are given back to the mesh arena)
+class ChunkPool {
+
+public:
+
+	~ChunkPool();
+
+	// returns an empty chunk (recycled if possible) at this chunk position
+	Chunk *acquire(int x, int z);
+
+	// gives back an unloaded chunk: it must not be linked or referenced anymore
+	// (meshes still being built for it are dropped when they come back)
+	void release(Chunk *chunk);
+
+	int allocatedCount() const { return n_allocated; }
+	int freeCount() const { return (int)freeChunks.size(); }
+
+private:
+
+	// deletes free chunks whose meshes are done until CHUNK_POOL_MAX_FREE are left
+	void trim();
+
+	std::vector<Chunk*> freeChunks;
+	int n_allocated = 0; // chunks currently allocated (in use and free)
+};
+
+#endif /* _CHUNK_POOL_H_ */
@@ -0,0 +1,36 @@
+#ifndef _FRAME_GRAPH_H_
+#define _FRAME_GRAPH_H_
+
+#include <glad/glad.h>
+
+#include "shader.h"
+#include "profiler.h"
+
+#define FRAME_GRAPH_SCALE 50.0f // frame time (ms) at the top of the graph
+#define FRAME_GRAPH_TARGET 16.667f // frame time of 60 FPS, frames above are drawn in yellow (red above twice this)
+#define FRAME_GRAPH_VERTEX_SIZE 5 // x, y, r, g, b
+
+// overlay of the last PROFILER_FRAMES frame times in the bottom left corner, one bar per frame
+class FrameGraph {
+
+public:
+
+	void init();
+
+	// draws the frame times kept by the profiler over the current frame
+	void render();
+
+private:
+
+	void pushLine(float x0, float y0, float x1, float y1, float r, float g, float b);
+
+	Shader shader;
+	unsigned int VAO = 0;
+	unsigned int VBO = 0;
+
+	float times[PROFILER_FRAMES];
+	float vertices[(PROFILER_FRAMES + 3) * 2 * FRAME_GRAPH_VERTEX_SIZE]; // a line per frame, the frame and target lines
+	int n_vertices = 0;
+};
+
+#endif /* _FRAME_GRAPH_H_ */
@@ -0,0 +1,35 @@
+#ifndef _FRUSTUM_H_
+#define _FRUSTUM_H_
+
+#include <glm/glm.hpp>
+
+#define FRUSTUM_PLANES 6
+
+// the six planes of the camera's view volume (a, b, c, d: inside if a*x + b*y + c*z + d >= 0)
+struct Frustum {
+	float planes[FRUSTUM_PLANES][4];
+};
+
+// axis aligned boxes stored as separate arrays so that they can be tested four at a time
+struct FrustumBoxes {
+	float *minX, *minY, *minZ;
+	float *maxX, *maxY, *maxZ;
+	int size;
+	int capacity;
+};
+
+// extracts the planes from a projection * view matrix (Gribb-Hartmann), in world space
+void extractFrustum(Frustum *frustum, const glm::mat4 &viewProjection);
+
+void clearFrustumBoxes(FrustumBoxes *boxes);
+
+void addFrustumBox(FrustumBoxes *boxes, glm::vec3 min, glm::vec3 max);
+
+void freeFrustumBoxes(FrustumBoxes *boxes);
+
+// writes 1 in visible[i] if box i intersects the frustum, 0 if it is fully outside one of its planes
+// conservative: a box crossing the corner of two planes may be kept even if it is outside
+// returns the number of visible boxes
+int cullFrustumBoxes(const Frustum *frustum, const FrustumBoxes *boxes, unsigned char *visible);
+
+#endif /* _FRUSTUM_H_ */
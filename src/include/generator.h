@@ -0,0 +1,65 @@
+#ifndef _GENERATOR_H_
+#define _GENERATOR_H_
+
+#include <vector>
+
+#include "chunk.h"
+#include "noise.h"
+#include "random.h"
+
+// random streams of the structures of a chunk (see WorldGenerator::pickStructure)
+struct StructureRandom {
+	ChunkRandom tower;
+	ChunkRandom tree;
+	ChunkRandom rock;
+	int hasTower; // one tower per chunk at most
+
+	StructureRandom(int seed, int chunkX, int chunkZ)
+		: tower(seed, chunkX, chunkZ, RANDOM_TOWER),
+		tree(seed, chunkX, chunkZ, RANDOM_TREE),
+		rock(seed, chunkX, chunkZ, RANDOM_ROCK),
+		hasTower(0) {}
+};
+
+// terrain generation of a world from its seed: chunk blocks and distant terrain heights
+// only fills blocks (no OpenGL, no window), the generate functions can run on any thread once init is done
+class WorldGenerator {
+
+public:
+
+	void init(int seed);
+
+	// fills the chunk's blocks, with the parts of the neighbors' structures that fall inside it
+	void generateChunk(Chunk *chunk, bool generateTrees);
+
+	// heights (y of the top block + 1) and top blocks of n x n columns, step blocks apart from (x0, z0)
+	// (multiples of step), straight from the noise: no block is generated (used for the distant terrain)
+	// structures are left out
+	void generateSurface(int x0, int z0, int n, int step, int *heights, Block *surface);
+
+	// height of the terrain of a column (filled up to value - 1), from its noise values
+	int getTerrainHeight(float noise, float continentalness);
+
+	int getSeed() const { return seed; }
+
+private:
+
+	// only the blocks that fall inside the chunk are placed (x and z can be outside of it)
+	void placeStructure(Chunk *chunk, const Structure *s, int x, int y, int z);
+
+	// structure of a column, NULL if none
+	// draws from the streams the same way for the chunk and for its neighbors replaying it
+	const Structure *pickStructure(StructureRandom *random, BiomeType biome, float continentalness, bool generateTrees);
+
+	// places the blocks of the structures of the 8 neighboring chunks that fall inside this one
+	void placeNeighborStructures(Chunk *chunk, bool generateTrees);
+
+	void placeCactus(Chunk *chunk, int x, int y, int z, int height);
+
+	int fitContinentalness(float x);
+
+	NoiseGenerator noiseGenerator;
+	int seed = 0;
+};
+
+#endif /* _GENERATOR_H_ */
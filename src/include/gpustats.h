@@ -0,0 +1,79 @@
+#ifndef _GPU_STATS_H_
+#define _GPU_STATS_H_
+
+#include <glad/glad.h>
+
+#define GPU_STATS_QUERY_SETS 2 // queries are read GPU_STATS_QUERY_SETS frames after they were issued (no stall)
+#define GPU_STATS_LOG_PERIOD 5.0f // seconds between two lines of the stats log
+#define GPU_STATS_LOG_FILE "render_stats.log" // rewritten for each session
+
+// render passes timed on the GPU, in drawing order
+enum GpuPass {
+	GPU_PASS_SKY, // sun and moon
+	GPU_PASS_LOD, // distant terrain
+	GPU_PASS_CHUNKS,
+	GPU_PASS_RAYCAST, // block wireframe
+	GPU_PASS_INVENTORY, // block in the corner of the screen
+	GPU_PASS_OVERLAY, // frame time graph
+	N_GPU_PASSES
+};
+
+// what a frame cost
+struct RenderStats {
+	float passTime[N_GPU_PASSES]; // GPU milliseconds of each pass (0 if it did not run)
+	int drawCalls;
+	long long vertices; // submitted (indices for indexed draws)
+	int chunksDrawn;
+	int sectionsDrawn;
+	long long bufferBytes; // vertex and index buffers of the meshes currently allocated (not reset each frame)
+};
+
+// GPU pass timers (GL_TIME_ELAPSED queries) and render counters
+// the counters of a frame are complete at the next beginFrame, the pass times GPU_STATS_QUERY_SETS frames later
+// must only be used from the main thread (the one with the OpenGL context)
+class GpuStats {
+
+public:
+
+	static void init();
+
+	// reads the timers of the query set about to be reused, ends the counters of the last frame
+	// and writes the log line when GPU_STATS_LOG_PERIOD has passed (time in seconds)
+	static void beginFrame(float time);
+
+	// passes can't be nested (a single GL_TIME_ELAPSED query can be active)
+	static void beginPass(GpuPass pass);
+	static void endPass();
+
+	static void addDraw(long long n_vertices) {
+		current.drawCalls++;
+		current.vertices += n_vertices;
+	}
+
+	static void addChunks(int n_chunks, int n_sections) {
+		current.chunksDrawn += n_chunks;
+		current.sectionsDrawn += n_sections;
+	}
+
+	// bytes is negative when a buffer is freed
+	static void addBufferBytes(long long bytes) {
+		current.bufferBytes += bytes;
+	}
+
+	// the last complete frame
+	static const RenderStats *getStats() { return &last; }
+
+	// sum of the pass times of the last measured frame
+	static float getGpuTime();
+
+	static const char *getPassName(GpuPass pass);
+
+private:
+
+	static void writeLog(float time);
+
+	inline static RenderStats current = {}; // frame being drawn
+	inline static RenderStats last = {};
+};
+
+#endif /* _GPU_STATS_H_ */
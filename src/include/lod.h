@@ -0,0 +1,112 @@
+#ifndef _LOD_H_
+#define _LOD_H_
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+#include "shader.h"
+#include "camera.h"
+#include "threadpool.h"
+#include "frustum.h"
+
+class World;
+
+#define LOD_TILE_SIZE 128 // blocks per side of a distant terrain tile (8x8 chunks, like the noise tiles)
+#define LOD_LEVELS 3
+#define LOD_MAX_RING 7 // tiles drawn around the player's tile (about 1 km)
+#define LOD_SKIRT_DEPTH 24.0f // the tile borders go down this much, to hide the cracks between two levels
+
+#define LOD_NEAR_PLANE 1.0f // the distant terrain has its own depth range (cleared before the chunks)
+#define LOD_FAR_PLANE 2500.0f
+
+#define MAX_LOD_JOBS 8 // tiles being built by the workers at the same time
+#define LOD_JOB_PRIORITY 1000000.0f // after every chunk job (their priority is a squared chunk distance)
+
+// blocks between two samples of a level, and farthest ring (in tiles) drawn at this level
+static const int lodSteps[LOD_LEVELS] = { 2, 4, 8 };
+static const int lodRings[LOD_LEVELS] = { 1, 3, LOD_MAX_RING };
+
+// vertex of the distant terrain: position in the tile (y is the height) and shaded color
+struct LodVertex {
+	float x, y, z;
+	uint32_t color; // RGBA8
+};
+
+// tile mesh built by a worker, waiting to be uploaded
+struct LodMesh {
+	int tileX, tileZ;
+	int level;
+	std::vector<LodVertex> vertices;
+	float minY, maxY;
+};
+
+// a tile of the distant terrain
+struct LodTile {
+	int tileX, tileZ;
+	int level = -1; // level of the uploaded mesh (-1 if there is none)
+	int wantedLevel;
+	bool building = false; // a worker is building its mesh
+	unsigned int VAO = 0, VBO = 0;
+	long long bufferBytes = 0; // size of the VBO
+	float minY, maxY;
+};
+
+// the terrain past the render distance, drawn as height fields in rings of tiles
+// around the player, coarser with the distance (samples 2, 4 then 8 blocks apart)
+// the heights come straight from the noise (WorldGenerator::generateSurface), no chunk is generated
+// tiles are built by the workers and uploaded on the main thread
+class LodManager {
+
+public:
+
+	~LodManager();
+
+	void init(ThreadPool *workers);
+
+	// picks the level of each tile around the player, queues the builds and uploads the built tiles
+	void update(World *world, Camera *camera);
+
+	// draws the tiles in the camera's view, except where the chunks are drawn (around chunkPosition)
+	void render(Shader *shader, Camera *camera, glm::ivec2 chunkPosition, float sunLight);
+
+	int tilesDrawn = 0; // tiles drawn last frame
+
+private:
+
+	// queues the build of a tile mesh at its wanted level
+	void submitTileJob(World *world, LodTile *tile, float priority);
+
+	// heights of the tile's samples (with one more around it for the normals) to a mesh
+	static void buildTileMesh(World *world, LodMesh *mesh);
+
+	void freeTile(LodTile *tile);
+
+	static uint64_t getTileKey(int tileX, int tileZ) {
+		return ((uint64_t)(uint32_t)tileX << 32) | (uint32_t)tileZ;
+	}
+
+	ThreadPool *workers = NULL;
+
+	std::unordered_map<uint64_t, LodTile> tiles;
+	glm::ivec2 playerTile = glm::ivec2(0, 0);
+	bool firstUpdate = true;
+
+	std::mutex builtMeshesMutex;
+	std::vector<LodMesh*> builtMeshes; // meshes built by the workers, waiting to be uploaded
+	int jobsInFlight = 0;
+
+	unsigned int EBOs[LOD_LEVELS]; // same grid (and skirts) for every tile of a level
+	int n_indices[LOD_LEVELS];
+
+	FrustumBoxes cullBoxes = {};
+	std::vector<LodTile*> cullTiles;
+	std::vector<unsigned char> cullVisible;
+};
+
+#endif /* _LOD_H_ */
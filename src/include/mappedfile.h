@@ -0,0 +1,35 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <cstddef>
+
+// read-only memory mapping of a whole file (mmap, or a file mapping on Windows)
+// the mapped size is fixed: map the file again to see data written past its end
+class MappedFile {
+
+public:
+
+	~MappedFile();
+
+	MappedFile() {}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// maps the file (unmapping the previous one), returns 0 on failure
+	int map(const char *path);
+
+	void unmap();
+
+	// asks the system to start reading these bytes from the disk (doesn't wait for them)
+	void prefetch(size_t offset, size_t length);
+
+	const unsigned char *getData() const { return data; }
+	size_t getSize() const { return size; }
+
+private:
+
+	unsigned char *data = NULL;
+	size_t size = 0;
+};
+
+#endif /* _MAPPED_FILE_H_ */
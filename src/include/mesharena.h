@@ -0,0 +1,87 @@
+#ifndef _MESH_ARENA_H_
+#define _MESH_ARENA_H_
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#define MESH_ARENA_INITIAL_SIZE (1 << 20) // vertices (8 MB), doubled when full
+#define MESH_ARENA_ALIGN 64 // allocations are rounded to this number of vertices
+#define MESH_VERTEX_BYTES 8 // size of a packed chunk vertex (see CHUNK_VERTEX_SIZE)
+#define QUAD_INDICES_MIN 16384 // number of quads the shared index buffer can draw at first
+
+// free range of the arena (in vertices)
+struct ArenaBlock {
+	int offset;
+	int size;
+};
+
+// layout of the commands read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+	unsigned int count;
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance;
+};
+
+// every chunk mesh lives in one vertex buffer, sub-allocated with a free list
+// all the visible chunks are then drawn with a single glMultiDrawElementsIndirect call,
+// the chunk origin of each draw being read from an instanced attribute (through baseInstance)
+// must only be used from the main thread
+class MeshArena {
+
+public:
+
+	void init();
+
+	// returns the offset (in vertices) of a free range of n_vertices, grows the arena if needed
+	int allocate(int n_vertices);
+
+	// gives back a range returned by allocate (same n_vertices, or its allocated size)
+	void release(int offset, int n_vertices);
+
+	// vertices really reserved by allocate(n_vertices), all of them can be used
+	static int getAllocatedSize(int n_vertices) {
+		return (n_vertices + MESH_ARENA_ALIGN - 1) / MESH_ARENA_ALIGN * MESH_ARENA_ALIGN;
+	}
+
+	// copies n_vertices packed vertices at this offset (the range must have been allocated)
+	void upload(int offset, const unsigned int *data, int n_vertices);
+
+	// makes sure the shared index buffer can draw n_quads quads
+	void reserveQuadIndices(int n_quads);
+
+	// draws are queued between beginDraws and endDraws (which draws them all)
+	void beginDraws();
+	void addDraw(int offset, int n_vertices, int xChunk, int zChunk);
+	void endDraws();
+
+	int getCapacity() const { return capacity; }
+	int getUsed() const { return n_used; }
+	bool usesMultiDraw() const { return multiDraw; }
+
+private:
+
+	void grow(int minCapacity);
+
+	void attachVertexBuffer();
+
+	unsigned int VAO = 0;
+	unsigned int VBO = 0; // all the chunk vertices
+	unsigned int originVBO = 0; // chunk position of each draw (instanced attribute)
+	unsigned int indirectBuffer = 0; // draw commands
+	unsigned int quadEBO = 0; // shared by all the draws (6 indices per quad)
+
+	int capacity = 0; // in vertices
+	int n_used = 0;
+	int quadEBO_size = 0; // number of quads the index buffer can draw
+	bool multiDraw = false; // false if the context has no glMultiDrawElementsIndirect (OpenGL < 4.3)
+
+	std::vector<ArenaBlock> freeBlocks; // sorted by offset, never adjacent
+
+	std::vector<DrawElementsIndirectCommand> commands;
+	std::vector<int> origins; // x, z for each command
+};
+
+#endif /* _MESH_ARENA_H_ */
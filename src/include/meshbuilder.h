@@ -0,0 +1,39 @@
+#ifndef _MESH_BUILDER_H_
+#define _MESH_BUILDER_H_
+
+#include <vector>
+
+#include "chunk.h"
+
+#define FACE_CROSS 6 // face index of the cross meshes (0 to 5 are the block faces)
+
+// builds chunk meshes from snapshots, without OpenGL (worker threads, headless benchmark)
+// the vertices are written to the builder's own buffers, which keep their memory from one build to the next:
+// use one builder per thread (see getThreadBuilder)
+class MeshBuilder {
+
+public:
+
+	~MeshBuilder();
+
+	// builds the vertex data of the snapshot's sections
+	// the returned mesh belongs to the builder and is only valid until its next build
+	const ChunkMesh *build(const ChunkSnapshot *snapshot);
+
+	// same as build, but returns a copy the caller owns (allocated at its exact size), for the meshes
+	// that wait to be uploaded
+	ChunkMesh *buildCopy(const ChunkSnapshot *snapshot);
+
+	// snapshot owned by the builder, reused for synchronous builds (see Chunk::calculateMesh)
+	ChunkSnapshot *getSnapshot();
+
+	// builder of the calling thread (created on first use, destroyed with the thread)
+	static MeshBuilder *getThreadBuilder();
+
+private:
+
+	ChunkMesh mesh; // all the sections of the last build, its data only grows
+	ChunkSnapshot *snapshot = NULL;
+};
+
+#endif /* _MESH_BUILDER_H_ */
@@ -0,0 +1,40 @@
+#ifndef _MESH_UPLOADER_H_
+#define _MESH_UPLOADER_H_
+
+#include "mesharena.h"
+
+class Chunk;
+struct ChunkSection;
+struct ChunkMesh;
+
+#define MESH_EDIT_SLACK 4 // sections rebuilt after an edit get 1/4 more vertices, so that the next edits fit in place
+
+// sends the meshes built by MeshBuilder to the GPU
+// owns the mesh arena (vertex array and buffers of all the chunks) and the ranges the chunk sections use in it
+// must only be used from the main thread
+class MeshUploader {
+
+public:
+
+	void init();
+
+	// copies the mesh's sections to the arena, sections that changed since the snapshot are skipped
+	// (a newer mesh is on its way)
+	// edited is set for the meshes rebuilt after a block edit (see MESH_EDIT_SLACK)
+	void upload(const ChunkMesh *mesh, bool edited = false);
+
+	// gives all the section meshes of a chunk back to the arena
+	void release(Chunk *chunk);
+
+	MeshArena *getArena() { return &arena; }
+
+private:
+
+	void uploadSection(ChunkSection *section, const unsigned int *data, int n_vertices, bool edited);
+
+	void freeSection(ChunkSection *section);
+
+	MeshArena arena;
+};
+
+#endif /* _MESH_UPLOADER_H_ */
@@ -0,0 +1,75 @@
+#ifndef _NOISE_H_
+#define _NOISE_H_
+
+#include <mutex>
+#include <memory>
+#include <vector>
+
+#include <FastNoise/FastNoise.h>
+
+#include "chunk.h"
+
+#define NOISE_TILE_CHUNKS 8 // chunks per side of a noise tile
+#define NOISE_TILE_SIZE (NOISE_TILE_CHUNKS * CHUNK_SIZE) // samples per side of a noise tile
+#define NOISE_CACHE_TILES 16 // tiles kept in memory (least recently used ones are dropped)
+
+// noise layers used by the terrain generation
+enum NoiseLayerType {
+	NOISE_HEIGHT,
+	NOISE_TEMPERATURE,
+	NOISE_HUMIDITY,
+	NOISE_CONTINENTALNESS,
+	N_NOISE_LAYERS
+};
+
+// a noise layer: its own node graph, set up once and never modified (so it can be used from any thread)
+struct NoiseLayer {
+	float frequency;
+	float scale;
+	int seed;
+	FastNoise::SmartNode<FastNoise::DomainScale> node;
+};
+
+// noise values of a chunk, for each layer (index = x + z * CHUNK_SIZE)
+struct ChunkNoise {
+	float layers[N_NOISE_LAYERS][CHUNK_SIZE * CHUNK_SIZE];
+};
+
+// noise values of NOISE_TILE_CHUNKS x NOISE_TILE_CHUNKS chunks, for each layer
+struct NoiseTile {
+	int x, z; // tile position
+	long long lastUsed;
+	std::once_flag generated; // the first thread needing the tile generates it, the others wait
+	float layers[N_NOISE_LAYERS][NOISE_TILE_SIZE * NOISE_TILE_SIZE];
+};
+
+// generates the terrain noise by tiles of several chunks: one large SIMD call per layer
+// is much faster than many 16x16 ones (the setup of each call dominates at that size)
+class NoiseGenerator {
+
+public:
+
+	void init(int seed);
+
+	// copies the noise of a chunk from its tile (generated if needed), can be called from any thread
+	void getChunkNoise(int chunkX, int chunkZ, ChunkNoise *out);
+
+	// noise of one layer on xSize x zSize points, step blocks apart from (xStart, zStart) (multiples of step)
+	// same sample positions as the tiles (for the distant terrain), not cached, can be called from any thread
+	void generateGrid(int layer, int xStart, int zStart, int xSize, int zSize, int step, float *out);
+
+private:
+
+	// returns the tile, added to the cache (not generated yet) if it isn't there
+	std::shared_ptr<NoiseTile> getTile(int tileX, int tileZ);
+
+	void generateTile(NoiseTile *tile);
+
+	NoiseLayer layers[N_NOISE_LAYERS];
+
+	std::mutex cacheMutex;
+	std::vector<std::shared_ptr<NoiseTile>> tiles; // kept alive by the threads using them when dropped
+	long long useCounter = 0;
+};
+
+#endif /* _NOISE_H_ */
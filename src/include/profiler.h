@@ -0,0 +1,88 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+
+#define PROFILER_ENABLED 1 // 0 compiles the zones out
+#define PROFILER_RING_SIZE 16384 // zones kept per thread, the oldest are overwritten
+#define PROFILER_FRAMES 256 // frame times kept for the graph and the stats
+#define PROFILER_TRACE_FILE "profile_trace.json" // written by exportTrace (open it in chrome://tracing or Perfetto)
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// times the rest of the enclosing scope, name must be a string literal (only its pointer is kept)
+#if PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+// a timed zone (nanoseconds since the profiler started)
+struct ProfileEvent {
+	const char *name;
+	int64_t start;
+	int64_t end;
+};
+
+// zones recorded by one thread, only written by that thread
+struct ProfileRing {
+	ProfileEvent events[PROFILER_RING_SIZE];
+	std::atomic<uint64_t> n_events{ 0 }; // recorded since the thread started (the ring keeps the last PROFILER_RING_SIZE)
+	int threadId;
+	std::atomic<const char*> threadName{ "thread" }; // set by setThreadName
+};
+
+// scoped zone profiler: each thread records its zones in its own ring, without locking
+// the main thread marks the frames (beginFrame) and can export all the rings as a Chrome trace
+class Profiler {
+
+public:
+
+	// zones are not recorded while this is false (a zone then costs a single load)
+	inline static std::atomic<bool> enabled{ true };
+
+	static int64_t getTime();
+
+	static void record(const char *name, int64_t start, int64_t end);
+
+	// names the calling thread in the trace (name must be a string literal)
+	static void setThreadName(const char *name);
+
+	// ends the previous frame and starts a new one, main thread only
+	static void beginFrame();
+
+	// duration of the last n_frames frames in milliseconds, oldest first, returns how many were written
+	static int getFrameTimes(float *times, int n_frames);
+
+	// average and maximum frame time over the kept frames, in milliseconds
+	static void getFrameStats(float *average, float *maximum);
+
+	// writes the zones of every thread to a Chrome trace JSON file, returns the number of zones written
+	// zones a thread records while it is written can be missing
+	static int exportTrace(const char *path);
+
+private:
+
+	static ProfileRing *getThreadRing();
+};
+
+// records a zone from its construction to its destruction (see PROFILE_ZONE)
+struct ProfileZone {
+
+	const char *name;
+	int64_t start;
+
+	ProfileZone(const char *name) : name(name) {
+		start = Profiler::enabled.load(std::memory_order_relaxed) ? Profiler::getTime() : -1;
+	}
+
+	~ProfileZone() {
+		if (start >= 0) {
+			Profiler::record(name, start, Profiler::getTime());
+		}
+	}
+};
+
+#endif /* _PROFILER_H_ */
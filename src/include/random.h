@@ -0,0 +1,54 @@
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <cstdint>
+
+// decoration features, each one draws from its own stream (adding draws to one doesn't change the others)
+enum RandomFeature {
+	RANDOM_TOWER,
+	RANDOM_TREE,
+	RANDOM_CACTUS,
+	RANDOM_HERB,
+	RANDOM_ROCK
+};
+
+// SplitMix64 output function: turns a counter into a well distributed 64-bit number
+inline uint64_t mixRandom(uint64_t x) {
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+// counter-based random numbers for the generation of a chunk
+// the n-th number only depends on (world seed, chunk position, feature, n): a chunk always gets the same
+// decorations, whatever the thread generating it and the order in which chunks are generated
+// there is no shared state: each generation creates its own streams
+class ChunkRandom {
+
+public:
+
+	ChunkRandom(int seed, int chunkX, int chunkZ, int feature) {
+		key = mixRandom(static_cast<uint32_t>(seed));
+		key = mixRandom(key ^ static_cast<uint32_t>(chunkX));
+		key = mixRandom(key ^ static_cast<uint32_t>(chunkZ));
+		key = mixRandom(key ^ static_cast<uint32_t>(feature));
+		counter = 0;
+	}
+
+	uint64_t next() {
+		return mixRandom(key + 0x9E3779B97F4A7C15ull * ++counter);
+	}
+
+	// between min and max (both included)
+	int nextInt(int min, int max) {
+		uint64_t range = static_cast<uint64_t>(max - min) + 1;
+		return min + static_cast<int>(((next() >> 32) * range) >> 32);
+	}
+
+private:
+
+	uint64_t key;
+	uint64_t counter;
+};
+
+#endif /* _RANDOM_H_ */
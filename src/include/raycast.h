@@ -4,6 +4,9 @@
 #include "camera.h"
 #include "world.h"
 #include "shader.h"
+#include "rayquery.h"
+
+#define RAYCAST_REACH 4.5f // blocks the player can reach
 
 class Raycast {
 
@@ -13,6 +16,8 @@ public:
 	glm::ivec3 hitBlockPos;
 	glm::ivec3 hitFace; // offset to the adjacent block to the face hit by raycast
 
+	float reach = RAYCAST_REACH;
+
 	Raycast() {};
 
 	void init();
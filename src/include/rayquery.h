@@ -0,0 +1,38 @@
+#ifndef _RAY_QUERY_H_
+#define _RAY_QUERY_H_
+
+#include <glm/glm.hpp>
+
+class Chunk;
+class ChunkManager;
+
+// a ray to trace through the blocks
+struct RayQuery {
+	glm::vec3 origin;
+	glm::vec3 dir; // doesn't have to be normalized
+	float maxDistance;
+};
+
+// first solid block met by a ray
+struct RayHit {
+	Chunk *chunk; // chunk of the block, NULL if nothing was hit
+	glm::ivec3 blockPos; // in the chunk
+	glm::ivec3 worldPos;
+	glm::ivec3 face; // offset to the block in front of the face that was hit (0 if the ray started in the block)
+	float distance; // along the ray, to the face
+};
+
+// walks the ray through the blocks (Amanatides-Woo DDA): every block it crosses is visited exactly once,
+// in order, moving between chunks with their neighbor links
+// blocks are centered on integer positions (like the chunk meshes)
+// returns 1 and fills hit if a solid block is closer than maxDistance, 0 if there is none or the ray
+// leaves the generated chunks first
+// does not use OpenGL, reads the chunks without locking them: call it from the main thread, or with
+// ChunkManager::chunksMutex held (see World::queryRays)
+int traceRay(ChunkManager *chunkManager, glm::vec3 origin, glm::vec3 dir, float maxDistance, RayHit *hit);
+
+// traces n rays, hits[i] being the result of rays[i], returns the number of rays that hit a block
+// same locking as traceRay
+int traceRays(ChunkManager *chunkManager, const RayQuery *rays, int n, RayHit *hits);
+
+#endif /* _RAY_QUERY_H_ */
@@ -0,0 +1,157 @@
+#ifndef _REGION_H_
+#define _REGION_H_
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+
+#include "mappedfile.h"
+
+class Chunk;
+
+#define REGION_SIZE 32 // chunks per side of a region file
+#define REGION_CHUNKS (REGION_SIZE * REGION_SIZE)
+#define REGION_SECTOR_SIZE 4096 // region files are allocated in sectors of this size
+#define REGION_HEADER_SECTORS 1 // the location table (one 4-byte entry per chunk)
+#define REGION_MAX_CHUNK_SECTORS 255 // a location stores the sector count on 8 bits
+
+#define REGION_COMPRESSION_RLE 1
+#define REGION_FORMAT_VERSION 1
+
+#define WORLD_SAVE_DIR "saves/world"
+
+#define REGION_PREFETCH_DISTANCE 3 // rows of chunks past the render distance prefetched in the movement direction
+#define REGION_STATS_INTERVAL 5.0 // seconds between two load latency reports
+
+// a chunk file (32x32 chunks), made of 4 KB sectors:
+// sector 0 holds the location of each chunk (first sector << 8 | sector count, 0 if the chunk is not saved)
+// and each saved chunk is [length (4 bytes)][compression (1 byte)][compressed blocks] in its own sectors
+// chunks are never overwritten in place: new data goes to free sectors, is synced, and only then the
+// location table is updated and synced, so a crash always leaves the previous version of the chunk readable
+// chunks are read from a memory mapping of the file, writes go through a regular file
+// must be locked by the caller: shared to read, exclusive to open and write (see RegionStore)
+class RegionFile {
+
+public:
+
+	~RegionFile();
+
+	// opens (or creates, if create is set) the region file, returns 0 on failure
+	int open(const char *path, bool create);
+
+	void close();
+
+	bool isOpen() const { return file != NULL; }
+
+	// returns the stored data of a chunk (index inside the region) in the mapping, NULL if it is not saved
+	// the pointer is valid as long as the lock is held
+	const unsigned char *getChunkData(int index, int *length);
+
+	// asks the system to read the sectors of a chunk ahead of time
+	void prefetchChunk(int index);
+
+	// writes the data of n chunks, with a single sync for the data and one for the location table
+	// written[i] tells if chunk i was written, returns the number of chunks written
+	// (the previous versions of the others are kept)
+	int writeChunks(const int *indices, const std::vector<unsigned char> *const *data, int n, int *written);
+
+	std::shared_mutex mutex;
+
+	bool missing = false; // the file doesn't exist (set by RegionStore, to not look for it again)
+
+private:
+
+	// returns the first sector of a run of n free sectors (at the end of the file if there is none)
+	int allocateSectors(int n);
+
+	void freeSectors(int first, int n);
+
+	int writeHeader();
+
+	int sync();
+
+	// maps the file again if it grew past the mapping
+	int updateMapping();
+
+	std::string path;
+	FILE *file = NULL;
+	MappedFile mapping;
+	uint32_t locations[REGION_CHUNKS];
+	std::vector<unsigned char> usedSectors; // 1 for the sectors holding the header or a chunk
+};
+
+// a chunk waiting to be written to its region file
+struct PendingChunk {
+	std::vector<unsigned char> data;
+	int revision; // to know if the chunk was saved again while it was being written
+};
+
+// all the region files of the world, opened on demand
+// chunks are saved to a pending list (cheap, main thread) and written by flush() (slow, any thread)
+// loading a chunk checks the pending list first, so it always sees the last saved version
+class RegionStore {
+
+public:
+
+	~RegionStore();
+
+	// sets the directory of the region files (created if needed)
+	void init(const char *directory);
+
+	// compresses the chunk's blocks and queues them for the next flush
+	void saveChunk(Chunk *chunk);
+
+	// fills an empty chunk with its saved blocks, returns 0 if it was never saved
+	// can be called from any thread
+	int loadChunk(Chunk *chunk);
+
+	// starts reading the saved chunks of this area (chunk positions, inclusive) from the disk
+	// can open region files: call it from a worker thread, regions being written are skipped
+	void prefetchChunks(int x0, int z0, int x1, int z1);
+
+	// writes the pending chunks to their region files (one sync per region file)
+	// can be called from any thread, only one flush runs at a time
+	void flush();
+
+	bool hasPendingChunks();
+
+	// prints the load latency of the chunks loaded since the last call (nothing if there were none)
+	void printLoadStats();
+
+	// reads and writes the world info (seed) kept next to the region files, read returns 0 if there is none
+	int readWorldInfo(int *seed);
+	void writeWorldInfo(int seed);
+
+	std::atomic<bool> flushQueued{ false }; // set by the chunk manager while a flush job is waiting
+
+private:
+
+	// returns the (open) region file, NULL if it doesn't exist and create is false
+	// regionsMutex must be locked
+	RegionFile *getRegion(int regionX, int regionZ, bool create);
+
+	std::string directory;
+
+	std::mutex regionsMutex; // protects regions and pendingChunks
+	std::unordered_map<uint64_t, RegionFile*> regions;
+	std::unordered_map<uint64_t, PendingChunk> pendingChunks; // keyed by chunk position
+	int revision = 0;
+
+	std::mutex flushMutex;
+
+	std::mutex statsMutex;
+	std::vector<float> loadTimes; // milliseconds to load each chunk since the last printLoadStats()
+};
+
+// compressed blocks of a chunk (run-length encoded), as stored in the region files
+void encodeChunk(Chunk *chunk, std::vector<unsigned char> *out);
+
+// fills an empty chunk with encoded blocks, returns 0 if the data is invalid
+int decodeChunk(const unsigned char *data, int size, Chunk *chunk);
+
+#endif /* _REGION_H_ */
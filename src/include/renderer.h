@@ -20,6 +20,8 @@
 // used to update view and projection matrices
 void prepareShaderMatrices(Shader* shader, Camera* camera);
 
+glm::mat4 getProjectionMatrix(Camera* camera);
+
 
 
 class BlockModel {
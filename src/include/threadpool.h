@@ -0,0 +1,54 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+// a job waiting in the pool
+struct PoolJob {
+	float priority; // jobs with the lowest value run first
+	std::function<void()> run;
+};
+
+// fixed set of worker threads running jobs by priority
+class ThreadPool {
+
+public:
+
+	ThreadPool() {}
+
+	~ThreadPool();
+
+	// starts n_threads workers
+	void start(int n_threads);
+
+	// waits for the running jobs to finish and drops the queued ones
+	void stop();
+
+	// adds a job to the queue, can be called from any thread
+	void submit(float priority, std::function<void()> job);
+
+	// number of queued and running jobs
+	int pendingJobs();
+
+	int threadCount() {
+		return threads.size();
+	}
+
+private:
+
+	void workerLoop();
+
+	std::vector<std::thread> threads;
+	std::vector<PoolJob> jobs; // min-heap on priority
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping = false;
+	int runningJobs = 0;
+};
+
+#endif /* _THREAD_POOL_H_ */
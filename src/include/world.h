@@ -3,12 +3,15 @@
 
 #include "shader.h"
 #include "chunkmanager.h"
+#include "generator.h"
+#include "rayquery.h"
+#include "profiler.h"
+#include "gpustats.h"
 
-#include <map>
 #include <random>
 #include <chrono>
+#include <mutex>
 
-#include <FastNoise/FastNoise.h>
 
 #define SUN_MOON_DISTANCE 150
 #define MAX_TIME 3600
@@ -17,12 +20,9 @@
 
 #define PI_6 (3.14 / 6) // pi / 6
 
-// a block that is in a chunk that has not been generated yet
-struct CachedBlock {
-	BlockType type;
-	int x;
-	int y;
-	int z;
+// a chunk generated by a worker, waiting to be added to the world on the main thread
+struct GeneratedChunk {
+	Chunk *chunk;
 };
 
 class World {
@@ -31,8 +31,8 @@ public:
 
 	ChunkManager chunkManager;
 
-	// uses a hashcode for int, and vector of cached blocks for each chunk
-	std::map<int, std::vector<CachedBlock>> cachedBlocks;
+	// fills the chunks from the seed (see generator.h)
+	WorldGenerator generator;
 
 	float time; // world time (between 0 and 3600)
 	float timeSpeed; // speed to update time
@@ -41,36 +41,26 @@ public:
 
 	World() {}
 
-	void initNoise() {
-		simplex = FastNoise::New<FastNoise::Simplex>();
-		fractal = FastNoise::New<FastNoise::FractalFBm>();
-		scale = FastNoise::New<FastNoise::DomainScale>();
-
-		fractal->SetSource(simplex);
-		fractal->SetOctaveCount(4);
-		fractal->SetLacunarity(1.3f);
-		fractal->SetGain(0.9f);
-		fractal->SetWeightedStrength(0.5f);
-
-		scale->SetSource(fractal);
-		scale->SetScale(0.8f);
-	}
-
 	void init() {
 		chunkManager.init();
 		chunkManager.world = this;
 
-		seed = getRandom(0, 3500);
+		// a saved world keeps its seed, so that regenerated chunks match the saved ones
+		if (!chunkManager.regionStore.readWorldInfo(&seed)) {
+			seed = getRandom(0, 3500);
+			chunkManager.regionStore.writeWorldInfo(seed);
+		}
 
 		std::cout << "seed = " << seed << "\n";
 
 		time = 0; // sunrise
 		timeSpeed = TIME_SPEED;
 
-		initNoise();
+		generator.init(seed);
 	}
 
 	void worldUpdate(Camera *camera, float deltaTime, int playerMoved) {
+		PROFILE_ZONE("worldUpdate");
 
 		chunkManager.update(camera, playerMoved);
 
@@ -135,9 +125,10 @@ public:
 		}
 	}
 
-	void renderWorld(Shader *chunkShader, Shader *blockShader, BlockModel *blockModel, Camera *camera) {
+	void renderWorld(Shader *chunkShader, Shader *blockShader, Shader *lodShader, BlockModel *blockModel, Camera *camera) {
 
 		// render sun and moon first (so they appear behind)
+		GpuStats::beginPass(GPU_PASS_SKY);
 		blockModel->renderBlock(blockShader,
 			camera->Position + glm::vec3(cos((time / MAX_TIME) * 6.38f - PI_6) * SUN_MOON_DISTANCE,
 				sin((time / MAX_TIME) * 6.38f - PI_6) * SUN_MOON_DISTANCE, 0),
@@ -151,218 +142,37 @@ public:
 			glm::vec3(0, 0, sin((time / MAX_TIME) * 6.38f - PI_6 + 3.14f)),
 			glm::vec3(20),
 			BlockType::MOON);
+		GpuStats::endPass();
 
 		// set sunLight uniform
 		float sunLight = calculateSunlight(time);
 		chunkShader->use();
 		chunkShader->setFloat("sunLight", sunLight);
 
-		// render chunks
-		chunkManager.renderChunks(chunkShader);
-	}
-
-	void requestNoiseGen(std::vector<float> *vect, int xStart, int yStart, int xSize, int ySize, float frequency, float noise_scale, int noise_seed) {
-		if (noise_seed == -1) {
-			noise_seed = seed; // use world seed if not specified
-		}
-		else {
-			noise_seed += seed;
-		}
-		scale->SetScale(noise_scale);
-		scale->GenUniformGrid2D(vect->data(), xStart, yStart, xSize, ySize, frequency, noise_seed);
-	}
-
-	int getChunkPosHash(int x, int z) {
-		// return (x << 16 + y);
-		return (x * 1000 + z);
-	}
-
-	// add a cached block in chunk of pos (xChunk, zChunk) at pos (x, y, z)
-	void addCachedBlock(BlockType type, int x, int y, int z, int xChunk, int zChunk) {
-		int hash = getChunkPosHash(xChunk, zChunk);
-		cachedBlocks[hash].push_back(CachedBlock{ type, x, y, z });
-	}
-
-	void placeStructure(Chunk *chunk, Structure s, int x, int y, int z) {
-
-		x += s.offset.x;
-		y += s.offset.y;
-		z += s.offset.z;
-
-		// iterate over the structure's data
-		for (int y_s = 0; y_s < s.dim.y; y_s++) {
-			int index = 0;
-			for (int z_s = 0; z_s < s.dim.z; z_s++) {
-				for (int x_s = 0; x_s < s.dim.x; x_s++) {
-
-					BlockType block = static_cast<BlockType>(s.blocks[y_s][index]);
-
-					if (block != BlockType::AIR) {
-
-						// block position
-						int xb = x + x_s - s.dim.x / 2;
-						int yb = y + y_s;
-						int zb = z + z_s - s.dim.z / 2;
-
-						// start with xChunk and zChunk = 0 (no neighbour offset)
-						int xChunk = 0;
-						int zChunk = 0;
-						int set = chunk->setBlockWithNeighbors(xb, yb, zb, block, &xChunk, &zChunk);
-
-						// block = BlockType::DEBUG_X;
-						// if we had to move chunks to place the block
-						if (set == BLOCK_NOT_PLACED) {
-							addCachedBlock(block,
-								abs(xb - 16 * xChunk) % 16,
-								yb,
-								abs(zb - 16 * zChunk) % 16,
-								chunk->position.x + xChunk,
-								chunk->position.y + zChunk);
-						}
-					}
-					index++;
-				}
-			}
-		}
-	}
-
-	int fitContinentalness(float x) {
-		if (x < 0.3) {
-			return 7.692*x + 17.69;
-		}
-		if (x < 0.4) {
-			return 300*x - 70;
-		}
-		if (x < 1.0) {
-			return 8.33*x + 46.67;
-		}
-	}
+		// render the distant terrain, in front of the sun and moon and behind the chunks
+		// (it has its own depth range, the depth buffer is cleared around it)
+		glClear(GL_DEPTH_BUFFER_BIT);
+		GpuStats::beginPass(GPU_PASS_LOD);
+		chunkManager.lodManager.render(lodShader, camera, chunkManager.getChunkPosition(&camera->Position), sunLight);
+		GpuStats::endPass();
+		glClear(GL_DEPTH_BUFFER_BIT);
+		chunkShader->use();
 
-	void placeCactus(Chunk *chunk, int x, int y, int z, int height) {
-		for (int i = 0; i < height; i++) {
-			chunk->setBlock(x, y + i, z, BlockType::CACTUS);
-		}
+		// render chunks
+		GpuStats::beginPass(GPU_PASS_CHUNKS);
+		chunkManager.renderChunks(chunkShader, camera);
+		GpuStats::endPass();
 	}
 
-	void generateChunk(Chunk *chunk, bool generateTrees) {
-
-		
-
-
-		std::vector<float> noise(16 * 16);
-
-		std::vector<float> temperature(16 * 16);
-		std::vector<float> humidity(16 * 16);
-
-		std::vector<float> continentalness(16 * 16);
-		std::vector<float> erosion(16 * 16);
-
-		requestNoiseGen(&noise, chunk->position.x * CHUNK_SIZE, chunk->position.y * CHUNK_SIZE, 16, 16, 0.02f, 0.8f, -1);
-		requestNoiseGen(&temperature, chunk->position.x * CHUNK_SIZE, chunk->position.y * CHUNK_SIZE, 16, 16, 0.005f, 0.3f, 1820);
-		requestNoiseGen(&humidity, chunk->position.x * CHUNK_SIZE, chunk->position.y * CHUNK_SIZE, 16, 16, 0.02f, 0.3f, 2067);
-		requestNoiseGen(&continentalness, chunk->position.x * CHUNK_SIZE, chunk->position.y * CHUNK_SIZE, 16, 16, 0.01f, 0.5f, 920);
-
-		int index = 0;
-
-		int hasTower = 0;
-
-		// APPLY NOISE
-		for (int z = 0; z < CHUNK_SIZE; z++)
-		{
-			for (int x = 0; x < CHUNK_SIZE; x++)
-			{
-				// int value = static_cast<int>((noise[index] * 1 + 1) * 13);
-				int value = static_cast<int>((noise[index] + 1) * 13);
-				value += static_cast<int>(fitContinentalness(continentalness[index]));
-
-				BiomeType biome = chunk->getBiome(temperature[index] + 0.5f, humidity[index] + 0.5f);
-
-				switch (biome) {
-				case BiomeType::PLAINS:
-					for (int y = 0; y < value - 1; y++) {
-						chunk->setBlock(x, y, z, BlockType::DIRT);
-					}
-					chunk->setBlock(x, value - 1, z, BlockType::GRASS);
-
-					if (!hasTower && getRandom(0, 10000) < 1) {
-						placeStructure(chunk, tower, x, value, z);
-						hasTower = 1;
-					}
-
-					break;
-				case BiomeType::FOREST:
-					for (int y = 0; y < value - 1; y++) {
-						chunk->setBlock(x, y, z, BlockType::DIRT);
-					}
-					chunk->setBlock(x, value - 1, z, BlockType::GRASS);
-
-					if (generateTrees) {
-
-						// trees
-						if (getRandom(0, 100) < 1) {
-							placeStructure(chunk, tree, x, value, z);
-						}
-
-					}
-					break;
-				case BiomeType::DESERT:
-					for (int y = 0; y < value - 1; y++) {
-						chunk->setBlock(x, y, z, BlockType::STONE);
-					}
-					chunk->setBlock(x, value - 1, z, BlockType::SAND);
-
-					break;
-				case BiomeType::JUNGLE:
-					for (int y = 0; y < value - 1; y++) {
-						chunk->setBlock(x, y, z, BlockType::STONE);
-					}
-					chunk->setBlock(x, value - 1, z, BlockType::SAND);
-
-					// cactus
-					if (getRandom(0, 80) < 1) {
-						placeCactus(chunk, x, value, z, getRandom(2, 5));
-					}
-					break;
-				}
-
-				if (value <= 0) {
-					chunk->setBlock(x, 0, z, BlockType::SAND);
-				}
-
-				// surface-level layer
-
-				// herb
-				if (biome == BiomeType::PLAINS || biome == BiomeType::FOREST) {
-					if (getRandom(0, 2) < 1)
-						chunk->setBlockWithCheck(x, value, z, BlockType::HERB);
-				}
-				// rocks
-				if (biome == BiomeType::DESERT || biome == BiomeType::JUNGLE
-					&& continentalness[index] < 0.3f) {
-					if (getRandom(0, 1000) < 1)
-						placeStructure(chunk, rock, x, value, z);
-				}
-
-				index++;
-			}
-		}
-
-		/*
-		// add blocks that were cached (placed by other chunks before this one was loaded)
-		int hash = getChunkPosHash(chunk->position.x, chunk->position.y);
-		if (cachedBlocks.find(hash) != cachedBlocks.end()) { // if we found an entry for this chunk
-			int size = cachedBlocks[hash].size();
-			for (int i = 0; i < size; i++) {
-				chunk->setBlock(cachedBlocks[hash][i].x, cachedBlocks[hash][i].y, cachedBlocks[hash][i].z, cachedBlocks[hash][i].type);
-			}
-			cachedBlocks.erase(hash);
-
-			// need to regenerate chunk mesh
-			chunkManager.unbuiltChunks.push_back(chunk);
-		}
-		*/
+	// traces a batch of rays through the generated chunks (see traceRays), returns the number of hits
+	// can be called from any thread: the blocks don't change during the call
+	// (hits[i].chunk is only valid until the chunk is unloaded, worldPos stays valid)
+	int queryRays(const RayQuery *rays, int n, RayHit *hits) {
+		std::shared_lock<std::shared_mutex> lock(chunkManager.chunksMutex);
+		return traceRays(&chunkManager, rays, n, hits);
 	}
 
+	// not deterministic, only used to pick the seed of a new world (generation uses ChunkRandom)
 	int getRandom(int min, int max) {
 		return std::uniform_int_distribution<int>{ min, max }(mt);
 	}
@@ -374,10 +184,6 @@ public:
 
 private:
 
-	// noise
-	FastNoise::SmartNode<FastNoise::Simplex> simplex;
-	FastNoise::SmartNode<FastNoise::FractalFBm> fractal;
-	FastNoise::SmartNode<FastNoise::DomainScale> scale;
 	int seed;
 
 	// random
@@ -0,0 +1,337 @@
+#include "lod.h"
+#include "world.h"
+#include "renderer.h"
+#include "profiler.h"
+#include "gpustats.h"
+
+#include <cmath>
+#include <algorithm>
+
+// grid points per side of a tile at this level (the last ones are shared with the next tile)
+static int getGridSize(int level) {
+	return LOD_TILE_SIZE / lodSteps[level] + 1;
+}
+
+static uint32_t packColor(float r, float g, float b) {
+	return (uint32_t)(r * 255.0f) | ((uint32_t)(g * 255.0f) << 8) | ((uint32_t)(b * 255.0f) << 16) | (255u << 24);
+}
+
+// average color of the top texture of the surface blocks
+static glm::vec3 getSurfaceColor(Block block) {
+	switch (block) {
+	case BlockType::GRASS:
+		return glm::vec3(0.40f, 0.60f, 0.27f);
+	case BlockType::SAND:
+		return glm::vec3(0.86f, 0.81f, 0.60f);
+	default:
+		return glm::vec3(0.53f, 0.38f, 0.26f);
+	}
+}
+
+LodManager::~LodManager() {
+	freeFrustumBoxes(&cullBoxes);
+}
+
+void LodManager::init(ThreadPool *workers) {
+
+	this->workers = workers;
+
+	// index buffer of each level: two triangles per grid cell, then a quad per border cell going down
+	// to the skirt vertices (stored after the grid, one row per border: z = 0, z = max, x = 0, x = max)
+	for (int level = 0; level < LOD_LEVELS; level++) {
+		int n = getGridSize(level);
+		std::vector<unsigned short> indices;
+		indices.reserve((n - 1) * (n - 1) * 6 + 4 * (n - 1) * 6);
+
+		for (int z = 0; z < n - 1; z++) {
+			for (int x = 0; x < n - 1; x++) {
+				unsigned short a = z * n + x;
+				unsigned short b = (z + 1) * n + x;
+				unsigned short c = z * n + x + 1;
+				unsigned short d = (z + 1) * n + x + 1;
+				// counter-clockwise seen from above
+				indices.insert(indices.end(), { a, b, c, c, b, d });
+			}
+		}
+
+		for (int border = 0; border < 4; border++) {
+			for (int k = 0; k < n - 1; k++) {
+				unsigned short top0, top1;
+				if (border < 2) {
+					int z = border == 0 ? 0 : n - 1;
+					top0 = z * n + k;
+					top1 = z * n + k + 1;
+				}
+				else {
+					int x = border == 2 ? 0 : n - 1;
+					top0 = k * n + x;
+					top1 = (k + 1) * n + x;
+				}
+				unsigned short skirt0 = n * n + border * n + k;
+				unsigned short skirt1 = skirt0 + 1;
+				indices.insert(indices.end(), { top0, top1, skirt1, top0, skirt1, skirt0 });
+			}
+		}
+
+		glGenBuffers(1, &EBOs[level]);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[level]);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+		n_indices[level] = indices.size();
+		GpuStats::addBufferBytes(indices.size() * sizeof(unsigned short));
+	}
+}
+
+void LodManager::update(World *world, Camera *camera) {
+	PROFILE_ZONE("lodUpdate");
+
+	glm::ivec2 tile_pos = glm::ivec2(
+		(int)floor(camera->Position.x / LOD_TILE_SIZE),
+		(int)floor(camera->Position.z / LOD_TILE_SIZE));
+
+	// the levels only change when the player enters another tile
+	if (firstUpdate || tile_pos != playerTile) {
+		firstUpdate = false;
+		playerTile = tile_pos;
+
+		// drop the tiles out of range (the ones being built are dropped when their mesh comes back)
+		for (auto it = tiles.begin(); it != tiles.end();) {
+			LodTile *tile = &it->second;
+			if (std::max(abs(tile->tileX - tile_pos.x), abs(tile->tileZ - tile_pos.y)) > LOD_MAX_RING && !tile->building) {
+				freeTile(tile);
+				it = tiles.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+
+		for (int z = tile_pos.y - LOD_MAX_RING; z <= tile_pos.y + LOD_MAX_RING; z++) {
+			for (int x = tile_pos.x - LOD_MAX_RING; x <= tile_pos.x + LOD_MAX_RING; x++) {
+				int ring = std::max(abs(x - tile_pos.x), abs(z - tile_pos.y));
+				int level = 0;
+				while (ring > lodRings[level]) {
+					level++;
+				}
+
+				LodTile *tile = &tiles[getTileKey(x, z)];
+				tile->tileX = x;
+				tile->tileZ = z;
+				tile->wantedLevel = level;
+			}
+		}
+	}
+
+	// upload the built meshes (the previous mesh of a tile is drawn until then, so there is no hole)
+	std::vector<LodMesh*> meshes;
+	{
+		std::lock_guard<std::mutex> lock(builtMeshesMutex);
+		meshes.swap(builtMeshes);
+	}
+	for (LodMesh *mesh : meshes) {
+		jobsInFlight--;
+
+		auto it = tiles.find(getTileKey(mesh->tileX, mesh->tileZ));
+		if (it == tiles.end()) {
+			delete mesh;
+			continue;
+		}
+		LodTile *tile = &it->second;
+		tile->building = false;
+
+		if (std::max(abs(tile->tileX - playerTile.x), abs(tile->tileZ - playerTile.y)) > LOD_MAX_RING) {
+			freeTile(tile);
+			tiles.erase(it);
+			delete mesh;
+			continue;
+		}
+
+		if (tile->VAO == 0) {
+			glGenVertexArrays(1, &tile->VAO);
+			glGenBuffers(1, &tile->VBO);
+		}
+		glBindVertexArray(tile->VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, tile->VBO);
+		glBufferData(GL_ARRAY_BUFFER, mesh->vertices.size() * sizeof(LodVertex), mesh->vertices.data(), GL_STATIC_DRAW);
+		GpuStats::addBufferBytes((long long)mesh->vertices.size() * sizeof(LodVertex) - tile->bufferBytes);
+		tile->bufferBytes = mesh->vertices.size() * sizeof(LodVertex);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LodVertex), (void*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(LodVertex), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBOs[mesh->level]);
+		glBindVertexArray(0);
+
+		tile->level = mesh->level;
+		tile->minY = mesh->minY;
+		tile->maxY = mesh->maxY;
+		delete mesh;
+	}
+
+	// queue the closest tiles that are missing or at the wrong level
+	int freeJobs = MAX_LOD_JOBS - jobsInFlight;
+	if (freeJobs <= 0) {
+		return;
+	}
+
+	std::vector<LodTile*> toBuild;
+	for (auto &entry : tiles) {
+		LodTile *tile = &entry.second;
+		if (!tile->building && tile->level != tile->wantedLevel) {
+			toBuild.push_back(tile);
+		}
+	}
+
+	int n = std::min((int)toBuild.size(), freeJobs);
+	auto getTileDistance = [tile_pos](const LodTile *tile) {
+		return (tile->tileX - tile_pos.x) * (tile->tileX - tile_pos.x) + (tile->tileZ - tile_pos.y) * (tile->tileZ - tile_pos.y);
+	};
+	std::partial_sort(toBuild.begin(), toBuild.begin() + n, toBuild.end(),
+		[&getTileDistance](const LodTile *a, const LodTile *b) {
+		return getTileDistance(a) < getTileDistance(b);
+	});
+
+	for (int i = 0; i < n; i++) {
+		submitTileJob(world, toBuild[i], LOD_JOB_PRIORITY + getTileDistance(toBuild[i]));
+	}
+}
+
+void LodManager::submitTileJob(World *world, LodTile *tile, float priority) {
+
+	LodMesh *mesh = new LodMesh();
+	mesh->tileX = tile->tileX;
+	mesh->tileZ = tile->tileZ;
+	mesh->level = tile->wantedLevel;
+
+	tile->building = true;
+	jobsInFlight++;
+
+	workers->submit(priority, [this, world, mesh]() {
+		buildTileMesh(world, mesh);
+
+		std::lock_guard<std::mutex> lock(builtMeshesMutex);
+		builtMeshes.push_back(mesh);
+	});
+}
+
+void LodManager::buildTileMesh(World *world, LodMesh *mesh) {
+
+	int step = lodSteps[mesh->level];
+	int n = getGridSize(mesh->level);
+	int samples = n + 2; // one more sample on each side for the normals of the borders
+
+	std::vector<int> heights(samples * samples);
+	std::vector<Block> surface(samples * samples);
+	world->generator.generateSurface(mesh->tileX * LOD_TILE_SIZE - step, mesh->tileZ * LOD_TILE_SIZE - step,
+		samples, step, heights.data(), surface.data());
+
+	const glm::vec3 lightDir = glm::normalize(glm::vec3(0.4f, 1.0f, 0.3f));
+
+	mesh->vertices.resize(n * n + 4 * n);
+	mesh->minY = 1e9f;
+	mesh->maxY = -1e9f;
+
+	for (int z = 0; z < n; z++) {
+		for (int x = 0; x < n; x++) {
+			int index = (z + 1) * samples + (x + 1);
+
+			// the top of the column is on the top face of its last block
+			float y = heights[index] - 0.5f;
+
+			glm::vec3 normal = glm::normalize(glm::vec3(
+				heights[index - 1] - heights[index + 1],
+				2.0f * step,
+				heights[index - samples] - heights[index + samples]));
+			// same range as the ambient occlusion of the chunks
+			float shade = 0.7f + 0.3f * std::max(0.0f, glm::dot(normal, lightDir));
+			glm::vec3 color = getSurfaceColor(surface[index]) * shade;
+
+			mesh->vertices[z * n + x] = { (float)(x * step), y, (float)(z * step), packColor(color.x, color.y, color.z) };
+
+			mesh->minY = std::min(mesh->minY, y);
+			mesh->maxY = std::max(mesh->maxY, y);
+		}
+	}
+
+	// skirts: the border vertices, lower
+	for (int border = 0; border < 4; border++) {
+		for (int k = 0; k < n; k++) {
+			int top;
+			if (border < 2) {
+				top = (border == 0 ? 0 : n - 1) * n + k;
+			}
+			else {
+				top = k * n + (border == 2 ? 0 : n - 1);
+			}
+			LodVertex vertex = mesh->vertices[top];
+			vertex.y -= LOD_SKIRT_DEPTH;
+			mesh->vertices[n * n + border * n + k] = vertex;
+		}
+	}
+	mesh->minY -= LOD_SKIRT_DEPTH;
+}
+
+void LodManager::render(Shader *shader, Camera *camera, glm::ivec2 chunkPosition, float sunLight) {
+
+	glm::mat4 projection = glm::perspective(glm::radians(camera->Zoom), (float)WIN_WIDTH / (float)WIN_HEIGHT,
+		LOD_NEAR_PLANE, LOD_FAR_PLANE);
+	glm::mat4 view = camera->GetViewMatrix();
+
+	clearFrustumBoxes(&cullBoxes);
+	cullTiles.clear();
+	for (auto &entry : tiles) {
+		LodTile *tile = &entry.second;
+		if (tile->level < 0) {
+			continue;
+		}
+		glm::vec3 origin = glm::vec3(tile->tileX * LOD_TILE_SIZE, 0, tile->tileZ * LOD_TILE_SIZE);
+		addFrustumBox(&cullBoxes,
+			origin + glm::vec3(0, tile->minY, 0),
+			origin + glm::vec3(LOD_TILE_SIZE, tile->maxY, LOD_TILE_SIZE));
+		cullTiles.push_back(tile);
+	}
+
+	Frustum frustum;
+	extractFrustum(&frustum, projection * view);
+
+	cullVisible.resize(cullTiles.size());
+	tilesDrawn = cullFrustumBoxes(&frustum, &cullBoxes, cullVisible.data());
+
+	shader->use();
+	shader->setMat4("projection", projection);
+	shader->setMat4("view", view);
+	shader->setFloat("sunLight", sunLight);
+
+	// the square of loaded chunks (block edges) is left to the chunks
+	shader->setVec2("detailMin", glm::vec2(
+		(chunkPosition.x - RENDER_DISTANCE) * CHUNK_SIZE - 0.5f,
+		(chunkPosition.y - RENDER_DISTANCE) * CHUNK_SIZE - 0.5f));
+	shader->setVec2("detailMax", glm::vec2(
+		(chunkPosition.x + RENDER_DISTANCE + 1) * CHUNK_SIZE - 0.5f,
+		(chunkPosition.y + RENDER_DISTANCE + 1) * CHUNK_SIZE - 0.5f));
+
+	// the skirts are seen from both sides
+	glDisable(GL_CULL_FACE);
+	for (int i = 0; i < cullTiles.size(); i++) {
+		if (cullVisible[i]) {
+			LodTile *tile = cullTiles[i];
+			shader->setVec3("tileOrigin", glm::vec3(tile->tileX * LOD_TILE_SIZE, 0, tile->tileZ * LOD_TILE_SIZE));
+			glBindVertexArray(tile->VAO);
+			glDrawElements(GL_TRIANGLES, n_indices[tile->level], GL_UNSIGNED_SHORT, 0);
+			GpuStats::addDraw(n_indices[tile->level]);
+		}
+	}
+	glBindVertexArray(0);
+	glEnable(GL_CULL_FACE);
+}
+
+void LodManager::freeTile(LodTile *tile) {
+	if (tile->VAO != 0) {
+		glDeleteVertexArrays(1, &tile->VAO);
+		glDeleteBuffers(1, &tile->VBO);
+		GpuStats::addBufferBytes(-tile->bufferBytes);
+		tile->VAO = 0;
+		tile->VBO = 0;
+		tile->bufferBytes = 0;
+	}
+	tile->level = -1;
+}
@@ -15,6 +15,9 @@
 #include "texture.h"
 #include "renderer.h"
 #include "raycast.h"
+#include "profiler.h"
+#include "framegraph.h"
+#include "gpustats.h"
 
 #include "shader.h"
 #include "camera.h"
@@ -22,12 +25,15 @@
 #define MOUSE_LEFT -1
 #define MOUSE_RIGHT 1
 
+#define TITLE_UPDATE_PERIOD 0.5f // seconds between two window title updates
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 int hasPlayerMovedXZ(GLFWwindow *window);
 int getMouseButton(GLFWwindow *window);
+int getKeyPressed(GLFWwindow *window, int key, bool *waitRelease);
 
 
 
@@ -39,6 +45,8 @@ float lastX = WIN_WIDTH / 2.0f;
 float lastY = WIN_HEIGHT / 2.0f;
 bool firstMouse = true;
 bool waitReleaseLeft = false, waitReleaseRight = false; // wait for mouse button to release
+bool waitReleaseMeshing = false; // wait for meshing switch key to release
+bool waitReleaseTrace = false, waitReleaseGraph = false; // profiler keys
 
 // for frame time logic
 float deltaTime = 0.0f;	// time between current frame and last frame
@@ -60,6 +68,7 @@ void mainLoop() {
 	// compile shaders
 	Shader chunkShader("shaders/chunk_v.vert", "shaders/chunk_f.frag"); // for rendering a chunk
 	Shader blockShader("shaders/block_v.vert", "shaders/block_f.frag"); // for rendering a single block (inventory block, sun, moon)
+	Shader lodShader("shaders/lod_v.vert", "shaders/lod_f.frag"); // for rendering the distant terrain
 	// get texture atlas
 	blocksTexture = createTexture("res/blocks_atlas.png");
 	chunkShader.use();
@@ -79,6 +88,15 @@ void mainLoop() {
 	Raycast raycast;
 	raycast.init();
 
+	// frame time overlay (F3)
+	FrameGraph frameGraph;
+	frameGraph.init();
+	bool showFrameGraph = false;
+	float lastTitleUpdate = 0.0f;
+
+	Profiler::setThreadName("main");
+	GpuStats::init();
+
 
 
 
@@ -87,20 +105,45 @@ void mainLoop() {
 	while (!glfwWindowShouldClose(window))
 	{
 
+		Profiler::beginFrame();
+		GpuStats::beginFrame(static_cast<float>(glfwGetTime()));
+
 		// frame time logic
 		float currentFrame = static_cast<float>(glfwGetTime());
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
-		float fps = 1.0f / deltaTime;
 
-		// set window title to show fps
-		std::stringstream ss;
-		ss << "kraf | " << fps << " FPS";
-		glfwSetWindowTitle(window, ss.str().c_str());
+		// set window title to show fps (a few times per second, not every frame)
+		if (currentFrame - lastTitleUpdate > TITLE_UPDATE_PERIOD) {
+			lastTitleUpdate = currentFrame;
+			float averageFrame, maxFrame;
+			Profiler::getFrameStats(&averageFrame, &maxFrame);
+
+			std::stringstream ss;
+			ss << "kraf | " << (averageFrame > 0.0f ? 1000.0f / averageFrame : 0.0f) << " FPS | "
+				<< averageFrame << " ms avg, " << maxFrame << " ms max, " << GpuStats::getGpuTime() << " ms GPU | "
+				<< world.chunkManager.sectionsDrawn << " sections drawn, " << world.chunkManager.sectionsCulled << " culled | "
+				<< world.chunkManager.lodManager.tilesDrawn << " distant tiles";
+			glfwSetWindowTitle(window, ss.str().c_str());
+		}
 
 
 		processInput(window);
 
+		// switch between naive and greedy meshing to compare them
+		if (getKeyPressed(window, GLFW_KEY_M, &waitReleaseMeshing)) {
+			Chunk::meshingMode = (Chunk::meshingMode == MESHING_GREEDY) ? MESHING_NAIVE : MESHING_GREEDY;
+			world.chunkManager.rebuildAllChunks();
+		}
+
+		// profiler: F2 writes the recorded zones to a trace file, F3 shows the frame times
+		if (getKeyPressed(window, GLFW_KEY_F2, &waitReleaseTrace)) {
+			int n_zones = Profiler::exportTrace(PROFILER_TRACE_FILE);
+			std::cout << n_zones << " zones written to " << PROFILER_TRACE_FILE << "\n";
+		}
+		if (getKeyPressed(window, GLFW_KEY_F3, &waitReleaseGraph)) {
+			showFrameGraph = !showFrameGraph;
+		}
 
 		// all the chunk stuff is happening here
 		// only update the chunk list if the player has moved
@@ -126,13 +169,17 @@ void mainLoop() {
 		// blockShader.use();
 		prepareShaderMatrices(&blockShader, &camera);
 
-		world.renderWorld(&chunkShader, &blockShader, &blockModel, &camera);
+		world.renderWorld(&chunkShader, &blockShader, &lodShader, &blockModel, &camera);
 
 		// raycasting and block breaking/placing
 		prepareShaderMatrices(raycast.getShader(), &camera);
-		if (raycast.raycast(window, &world, &camera)) {
+		GpuStats::beginPass(GPU_PASS_RAYCAST);
+		int blockHit = raycast.raycast(window, &world, &camera);
+		GpuStats::endPass();
+		if (blockHit) {
 			// a block was hit
 			int mouseAction = getMouseButton(window);
+			std::unique_lock<std::shared_mutex> lock(world.chunkManager.chunksMutex);
 			if (mouseAction == MOUSE_LEFT) {
 				raycast.breakBlock();
 			}
@@ -146,19 +193,30 @@ void mainLoop() {
 
 		// render inventory block in the corner of the screen
 		prepareShaderMatrices(&blockShader, &camera);
+		GpuStats::beginPass(GPU_PASS_INVENTORY);
 		blockModel.renderBlock(&blockShader,
 			camera.Position + camera.Right * 1.25f + camera.Front - camera.Up * 0.75f,
 			glm::vec3(camera.Pitch, 0.0f, 0.0f),
 			glm::vec3(0.5f, 0.5f, 0.5),
 			inventory[inventoryIndex]);
-		
+		GpuStats::endPass();
 
+		if (showFrameGraph) {
+			GpuStats::beginPass(GPU_PASS_OVERLAY);
+			frameGraph.render();
+			GpuStats::endPass();
+		}
 
 		// swap buffers and poll events
-		glfwSwapBuffers(window);
+		{
+			PROFILE_ZONE("swapBuffers"); // includes the wait for vsync
+			glfwSwapBuffers(window);
+		}
 		glfwPollEvents();
 	}
 
+	// write the player's changes before quitting
+	world.chunkManager.saveModifiedChunks();
 
 }
 
@@ -197,6 +255,18 @@ int getMouseButton(GLFWwindow *window) {
 	return 0;
 }
 
+// returns 1 when the key is pressed (once until it is released)
+int getKeyPressed(GLFWwindow *window, int key, bool *waitRelease) {
+	if (glfwGetKey(window, key) == GLFW_RELEASE && *waitRelease) {
+		*waitRelease = false;
+	}
+	if (glfwGetKey(window, key) == GLFW_PRESS && !*waitRelease) {
+		*waitRelease = true;
+		return 1;
+	}
+	return 0;
+}
+
 int hasPlayerMovedXZ(GLFWwindow *window) {
 	return (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS
 		|| glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS
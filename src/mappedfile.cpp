@@ -0,0 +1,128 @@
+#include "mappedfile.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+	unmap();
+}
+
+#ifdef _WIN32
+
+int MappedFile::map(const char *path) {
+
+	unmap();
+
+	// the file can still be written (through another handle) while it is mapped
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return 0;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return 0;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) {
+		return 0;
+	}
+
+	// the view keeps the mapping alive
+	data = (unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == NULL) {
+		std::cout << "Error MappedFile::map(): could not map " << path << "\n";
+		return 0;
+	}
+
+	size = (size_t)fileSize.QuadPart;
+	return 1;
+}
+
+void MappedFile::unmap() {
+	if (data != NULL) {
+		UnmapViewOfFile(data);
+		data = NULL;
+		size = 0;
+	}
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) {
+	if (data == NULL || offset >= size) {
+		return;
+	}
+#if _WIN32_WINNT >= 0x0602 // PrefetchVirtualMemory needs Windows 8
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = data + offset;
+	range.NumberOfBytes = (offset + length > size) ? size - offset : length;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+}
+
+#else
+
+int MappedFile::map(const char *path) {
+
+	unmap();
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return 0;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return 0;
+	}
+
+	// the mapping stays valid once the file is closed
+	void *mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		std::cout << "Error MappedFile::map(): could not map " << path << "\n";
+		return 0;
+	}
+
+	data = (unsigned char*)mapped;
+	size = (size_t)st.st_size;
+	return 1;
+}
+
+void MappedFile::unmap() {
+	if (data != NULL) {
+		munmap(data, size);
+		data = NULL;
+		size = 0;
+	}
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) {
+	if (data == NULL || offset >= size) {
+		return;
+	}
+
+	// madvise works on whole pages
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t start = offset / page * page;
+	size_t end = std::min(offset + length, size);
+	madvise(data + start, end - start, MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,224 @@
+#include "mesharena.h"
+#include "gpustats.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+
+// OpenGL 4.3, not in the 3.3 loader: loaded by init if the context has it
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+static MultiDrawElementsIndirectProc multiDrawElementsIndirect = NULL;
+
+void MeshArena::init() {
+
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major > 4 || (major == 4 && minor >= 3)) {
+		multiDrawElementsIndirect = (MultiDrawElementsIndirectProc)glfwGetProcAddress("glMultiDrawElementsIndirect");
+	}
+	multiDraw = multiDrawElementsIndirect != NULL;
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &originVBO);
+	glGenBuffers(1, &indirectBuffer);
+	glGenBuffers(1, &quadEBO);
+
+	capacity = MESH_ARENA_INITIAL_SIZE;
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, (size_t)capacity * MESH_VERTEX_BYTES, NULL, GL_DYNAMIC_DRAW);
+	GpuStats::addBufferBytes((long long)capacity * MESH_VERTEX_BYTES);
+	freeBlocks.push_back({ 0, capacity });
+
+	reserveQuadIndices(QUAD_INDICES_MIN);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO); // stored in the VAO
+
+	attachVertexBuffer();
+
+	// chunk origin attribute: one per draw (the draw's baseInstance selects it)
+	glBindBuffer(GL_ARRAY_BUFFER, originVBO);
+	glVertexAttribIPointer(1, 2, GL_INT, 2 * sizeof(int), (void*)0);
+	glVertexAttribDivisor(1, 1);
+	if (multiDraw) {
+		glEnableVertexAttribArray(1);
+	}
+	// otherwise the attribute array stays disabled: its value is set before each draw with glVertexAttribI2i
+
+	glBindVertexArray(0);
+}
+
+void MeshArena::attachVertexBuffer() {
+	// packed vertex attribute (integers, unpacked in the vertex shader), VAO must be bound
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, MESH_VERTEX_BYTES, (void*)0);
+	glEnableVertexAttribArray(0);
+}
+
+int MeshArena::allocate(int n_vertices) {
+
+	int size = getAllocatedSize(n_vertices);
+
+	// first fit
+	for (int i = 0; i < freeBlocks.size(); i++) {
+		if (freeBlocks[i].size >= size) {
+			int offset = freeBlocks[i].offset;
+			freeBlocks[i].offset += size;
+			freeBlocks[i].size -= size;
+			if (freeBlocks[i].size == 0) {
+				freeBlocks.erase(freeBlocks.begin() + i);
+			}
+			n_used += size;
+			return offset;
+		}
+	}
+
+	// no free range is big enough
+	grow(capacity + size);
+	return allocate(n_vertices);
+}
+
+void MeshArena::release(int offset, int n_vertices) {
+
+	int size = getAllocatedSize(n_vertices);
+	n_used -= size;
+
+	// insert the range at its place and merge it with the ranges it touches
+	auto it = std::lower_bound(freeBlocks.begin(), freeBlocks.end(), offset,
+		[](const ArenaBlock& block, int offset) { return block.offset < offset; });
+	int i = it - freeBlocks.begin();
+	freeBlocks.insert(it, { offset, size });
+
+	if (i + 1 < freeBlocks.size() && freeBlocks[i].offset + freeBlocks[i].size == freeBlocks[i + 1].offset) {
+		freeBlocks[i].size += freeBlocks[i + 1].size;
+		freeBlocks.erase(freeBlocks.begin() + i + 1);
+	}
+	if (i > 0 && freeBlocks[i - 1].offset + freeBlocks[i - 1].size == freeBlocks[i].offset) {
+		freeBlocks[i - 1].size += freeBlocks[i].size;
+		freeBlocks.erase(freeBlocks.begin() + i);
+	}
+}
+
+void MeshArena::upload(int offset, const unsigned int *data, int n_vertices) {
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, (size_t)offset * MESH_VERTEX_BYTES, (size_t)n_vertices * MESH_VERTEX_BYTES, data);
+}
+
+void MeshArena::grow(int minCapacity) {
+
+	int newCapacity = capacity;
+	while (newCapacity < minCapacity) {
+		newCapacity *= 2;
+	}
+
+	// copy the meshes to the new buffer on the GPU
+	unsigned int newVBO;
+	glGenBuffers(1, &newVBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newVBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, (size_t)newCapacity * MESH_VERTEX_BYTES, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (size_t)capacity * MESH_VERTEX_BYTES);
+	glDeleteBuffers(1, &VBO);
+	VBO = newVBO;
+	GpuStats::addBufferBytes((long long)(newCapacity - capacity) * MESH_VERTEX_BYTES);
+
+	glBindVertexArray(VAO);
+	attachVertexBuffer();
+	glBindVertexArray(0);
+
+	// the new space goes at the end (merged with the last free range if it touches it)
+	if (freeBlocks.size() > 0 && freeBlocks.back().offset + freeBlocks.back().size == capacity) {
+		freeBlocks.back().size += newCapacity - capacity;
+	}
+	else {
+		freeBlocks.push_back({ capacity, newCapacity - capacity });
+	}
+	capacity = newCapacity;
+}
+
+void MeshArena::reserveQuadIndices(int n_quads) {
+
+	if (n_quads <= quadEBO_size) {
+		return;
+	}
+
+	int size = std::max(n_quads, std::max(QUAD_INDICES_MIN, quadEBO_size * 2));
+	std::vector<unsigned int> indices(size * 6);
+	for (int i = 0; i < size; i++) {
+		// two triangles split along the 0-2 diagonal, same winding as the quad
+		indices[i * 6 + 0] = i * 4 + 0;
+		indices[i * 6 + 1] = i * 4 + 1;
+		indices[i * 6 + 2] = i * 4 + 2;
+		indices[i * 6 + 3] = i * 4 + 2;
+		indices[i * 6 + 4] = i * 4 + 3;
+		indices[i * 6 + 5] = i * 4 + 0;
+	}
+
+	// not bound as an element buffer here: that would change the currently bound VAO
+	glBindBuffer(GL_COPY_WRITE_BUFFER, quadEBO);
+	glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GpuStats::addBufferBytes((long long)(size - quadEBO_size) * 6 * sizeof(unsigned int));
+	quadEBO_size = size;
+}
+
+void MeshArena::beginDraws() {
+	commands.clear();
+	origins.clear();
+}
+
+void MeshArena::addDraw(int offset, int n_vertices, int xChunk, int zChunk) {
+
+	DrawElementsIndirectCommand command;
+	command.count = n_vertices / 4 * 6;
+	command.instanceCount = 1;
+	command.firstIndex = 0;
+	command.baseVertex = offset;
+	command.baseInstance = commands.size(); // index of the draw's origin
+
+	commands.push_back(command);
+	origins.push_back(xChunk);
+	origins.push_back(zChunk);
+}
+
+void MeshArena::endDraws() {
+
+	if (commands.size() == 0) {
+		return;
+	}
+
+	glBindVertexArray(VAO);
+
+	long long n_indices = 0;
+	for (int i = 0; i < commands.size(); i++) {
+		n_indices += commands[i].count;
+	}
+
+	if (multiDraw) {
+		// buffers are orphaned each frame so that the previous frame's draws are not waited for
+		glBindBuffer(GL_ARRAY_BUFFER, originVBO);
+		glBufferData(GL_ARRAY_BUFFER, origins.size() * sizeof(int), origins.data(), GL_STREAM_DRAW);
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+
+		multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, commands.size(), 0);
+		GpuStats::addDraw(n_indices);
+	}
+	else {
+		// one draw per chunk, but still no buffer or VAO switch between them
+		for (int i = 0; i < commands.size(); i++) {
+			glVertexAttribI2i(1, origins[i * 2], origins[i * 2 + 1]);
+			glDrawElementsBaseVertex(GL_TRIANGLES, commands[i].count, GL_UNSIGNED_INT, (void*)0, commands[i].baseVertex);
+			GpuStats::addDraw(commands[i].count);
+		}
+	}
+
+	glBindVertexArray(0);
+}
@@ -0,0 +1,354 @@
+#include "meshbuilder.h"
+#include "profiler.h"
+
+// axes (0 = x, 1 = y, 2 = z) of each face for the greedy mesher: u, v (face plane) and normal
+/* order: back, front, left, right, bottom, top */
+static const int greedyAxes[6][3] = {
+	{ 0, 1, 2 },
+	{ 0, 1, 2 },
+	{ 2, 1, 0 },
+	{ 2, 1, 0 },
+	{ 0, 2, 1 },
+	{ 0, 2, 1 }
+};
+
+// offset to the block in front of each face
+/* order: back, front, left, right, bottom, top */
+static const int faceNormals[6][3] = {
+	{ 0, 0, -1 },
+	{ 0, 0, 1 },
+	{ -1, 0, 0 },
+	{ 1, 0, 0 },
+	{ 0, -1, 0 },
+	{ 0, 1, 0 }
+};
+
+/* check if a face has no solid block in front of it */
+static int checkFaceFree(const ChunkSnapshot *snapshot, int x, int y, int z, int face) {
+	/* order: back, front, left, right, bottom, top */
+	return !Chunk::isSolid(snapshot->get(x + faceNormals[face][0], y + faceNormals[face][1], z + faceNormals[face][2]));
+}
+
+// calculates the ambient occlusion level (0 to 3, 3 being unoccluded) for a vertex
+static int calculateAOLevel(const ChunkSnapshot *snapshot, glm::vec3 vert, glm::ivec3 blockPos) {
+	// calculate "direction" of block center to vertex position
+	glm::ivec3 v = glm::ivec3(vert.x * 2, vert.y * 2, vert.z * 2);
+
+	glm::ivec3 cornerPos = blockPos + v;
+	glm::ivec3 sidePos1 = blockPos + glm::ivec3(v.x, v.y, 0);
+	glm::ivec3 sidePos2 = blockPos + glm::ivec3(0, v.y, v.z);
+
+	int side1 = Chunk::isSolid(snapshot->get(sidePos1.x, sidePos1.y, sidePos1.z));
+	int side2 = Chunk::isSolid(snapshot->get(sidePos2.x, sidePos2.y, sidePos2.z));
+	int corner = Chunk::isSolid(snapshot->get(cornerPos.x, cornerPos.y, cornerPos.z));
+	
+	if (side1 && side2) {
+		return 0;
+	}
+	else if ((side1 && corner) || (side2 && corner)) {
+		return 1;
+	}
+	else if (side1 || corner || side2) {
+		return 2;
+	}
+	else return 3;
+}
+
+// packs a single vertex into the mesh data (see CHUNK_VERTEX_SIZE for the layout)
+// positions are on block corners (x.5), uv are whole numbers (over 1 for merged faces, the texture is then tiled)
+static void pushVertex(std::vector<unsigned int> *data, glm::vec3 pos, glm::vec2 uv, BlockFace texture, int face, int ao) {
+	unsigned int x = static_cast<unsigned int>(pos.x + 0.5f);
+	unsigned int y = static_cast<unsigned int>(pos.y + 0.5f);
+	unsigned int z = static_cast<unsigned int>(pos.z + 0.5f);
+	unsigned int tile = texture.y * ATLAS_SIZE + texture.x;
+
+	data->push_back(x | (y << 5) | (z << 14) | (face << 19) | (ao << 22));
+	data->push_back(static_cast<unsigned int>(uv.x) | (static_cast<unsigned int>(uv.y) << 9) | (tile << 18));
+}
+
+// writes the 4 corners of a quad, in winding order
+// the quad is split along the diagonal with the brightest corners, so that the ambient occlusion
+// of a single dark corner stays in its triangle instead of spreading over the whole quad
+static void pushQuad(std::vector<unsigned int> *data, const glm::vec3 pos[4], const glm::vec2 uv[4], BlockFace texture, int face, const int ao[4]) {
+	// the index buffer always splits along 0-2: start at corner 1 to split along 1-3
+	int first = (ao[0] + ao[2] < ao[1] + ao[3]) ? 1 : 0;
+	for (int k = 0; k < 4; k++) {
+		int corner = (first + k) & 3;
+		pushVertex(data, pos[corner], uv[corner], texture, face, ao[corner]);
+	}
+}
+
+// adds the two faces of a cross mesh block (herbs...)
+static void addCrossMesh(std::vector<unsigned int> *data, Block block, glm::vec3 blockPos) {
+	const int ao[4] = { 3, 3, 3, 3 }; // never occluded for cross meshes
+	for (int i = 0; i < 2; i++) {
+		glm::vec3 pos[4];
+		glm::vec2 uv[4];
+		for (int k = 0; k < 4; k++) {
+			const float *corner = &crossQuadData[i][k * 5];
+			pos[k] = glm::vec3(corner[0], corner[1], corner[2]) + blockPos;
+			uv[k] = glm::vec2(corner[3], corner[4]);
+		}
+		pushQuad(data, pos, uv, faceTexture[block][i], FACE_CROSS, ao);
+	}
+}
+
+// one quad per visible block face, for the rows y0 to y1 (excluded)
+static void buildNaiveMesh(const ChunkSnapshot *snapshot, int y0, int y1, std::vector<unsigned int> *data) {
+
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+
+		// only air above the highest column of this row
+		int rowTop = 0;
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			rowTop = std::max(rowTop, (int)snapshot->heightmap[COLUMN_INDEX(x, z)]);
+		}
+		rowTop = std::min(rowTop, y1);
+
+		for (int y = y0; y < rowTop; y++) {
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				
+				// for each block
+				Block block = snapshot->get(x, y, z);
+				if (block == BlockType::AIR) {
+					continue;
+				}
+
+				// calculate local position of the block (in the chunk)
+				glm::ivec3 blockPos = glm::ivec3(x, y, z);
+
+				if (!Chunk::blockMesh(block)) {
+					addCrossMesh(data, block, glm::vec3(x, y, z));
+					continue;
+				}
+
+				/* for each face */
+				/* order: back, front, left, right, bottom, top */
+				for (int i = 0; i < 6; i++) {
+
+					if (!checkFaceFree(snapshot, x, y, z, i)) {
+						continue;
+					}
+
+					glm::vec3 pos[4];
+					glm::vec2 uv[4];
+					int ao[4];
+					for (int k = 0; k < 4; k++) {
+						const float *corner = &faceQuadData[i][k * 5];
+						glm::vec3 vert = glm::vec3(corner[0], corner[1], corner[2]);
+
+						pos[k] = vert + glm::vec3(x, y, z);
+						uv[k] = glm::vec2(corner[3], corner[4]);
+						ao[k] = calculateAOLevel(snapshot, vert, blockPos);
+					}
+					pushQuad(data, pos, uv, faceTexture[block][i], i, ao);
+				}
+			}
+		}
+	}
+}
+
+// returns the corner index (0 to 3) of a face vertex, from its u and v sides
+static int greedyCorner(int face, glm::vec3 vert) {
+	int u = greedyAxes[face][0];
+	int v = greedyAxes[face][1];
+	return (vert[u] > 0.0f ? 1 : 0) + (vert[v] > 0.0f ? 2 : 0);
+}
+
+// returns the key used to merge a face in the greedy mesher (0 if the face is not visible)
+// faces can only be merged if they share the same texture and the same ambient occlusion
+static int getGreedyFaceKey(const ChunkSnapshot *snapshot, int x, int y, int z, int face) {
+
+	Block block = snapshot->get(x, y, z);
+	if (block == BlockType::AIR || !Chunk::blockMesh(block) || !checkFaceFree(snapshot, x, y, z, face)) {
+		return 0;
+	}
+
+	// ambient occlusion level of each corner, in face data order (2 bits each)
+	int ao = 0;
+	for (int j = 0; j < N_QUAD_DATA; j += 5) {
+		glm::vec3 vert = glm::vec3(faceQuadData[face][j], faceQuadData[face][j + 1], faceQuadData[face][j + 2]);
+		int corner = greedyCorner(face, vert);
+		ao |= calculateAOLevel(snapshot, vert, glm::ivec3(x, y, z)) << (corner * 2);
+	}
+
+	BlockFace texture = faceTexture[block][face];
+	return 1 + (texture.y * ATLAS_SIZE + texture.x) + (ao << 8);
+}
+
+// merges coplanar faces with the same texture and ambient occlusion into larger quads, for the rows y0 to y1 (excluded)
+static void buildGreedyMesh(const ChunkSnapshot *snapshot, int y0, int y1, std::vector<unsigned int> *data) {
+
+	// the rows above the highest block only have air (no face to find)
+	y1 = std::min(y1, snapshot->maxHeight);
+	if (y1 <= y0) {
+		return;
+	}
+
+	// cross meshes are never merged
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		for (int y = y0; y < y1; y++) {
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				Block block = snapshot->get(x, y, z);
+				if (block != BlockType::AIR && !Chunk::blockMesh(block)) {
+					addCrossMesh(data, block, glm::vec3(x, y, z));
+				}
+			}
+		}
+	}
+
+	int dims[3] = { CHUNK_SIZE, y1 - y0, CHUNK_SIZE };
+	// mask of the face keys of a single slice, indexed by [u + v * uSize]
+	int mask[CHUNK_SIZE * std::max(CHUNK_SIZE, SECTION_HEIGHT)];
+
+	/* order: back, front, left, right, bottom, top */
+	for (int face = 0; face < 6; face++) {
+
+		int u = greedyAxes[face][0];
+		int v = greedyAxes[face][1];
+		int n = greedyAxes[face][2];
+		int uSize = dims[u];
+		int vSize = dims[v];
+
+		for (int slice = 0; slice < dims[n]; slice++) {
+
+			// fill the mask for this slice
+			for (int j = 0; j < vSize; j++) {
+				for (int i = 0; i < uSize; i++) {
+					int pos[3];
+					pos[u] = i;
+					pos[v] = j;
+					pos[n] = slice;
+					pos[1] += y0;
+					mask[i + j * uSize] = getGreedyFaceKey(snapshot, pos[0], pos[1], pos[2], face);
+				}
+			}
+
+			// merge faces into quads
+			for (int j = 0; j < vSize; j++) {
+				for (int i = 0; i < uSize; ) {
+
+					int key = mask[i + j * uSize];
+					if (key == 0) {
+						i++;
+						continue;
+					}
+
+					int width = 1;
+					int height = 1;
+
+					// faces with a gradient of ambient occlusion are not merged (it would stretch the gradient)
+					int ao = (key - 1) >> 8;
+					int uniformAO = (ao == (ao & 3) * 0x55);
+
+					if (uniformAO) {
+						// grow along u
+						while (i + width < uSize && mask[i + width + j * uSize] == key) {
+							width++;
+						}
+						// grow along v while the whole row matches
+						int done = 0;
+						while (j + height < vSize && !done) {
+							for (int k = 0; k < width; k++) {
+								if (mask[i + k + (j + height) * uSize] != key) {
+									done = 1;
+									break;
+								}
+							}
+							if (!done) {
+								height++;
+							}
+						}
+					}
+
+					// clear the merged faces from the mask
+					for (int l = 0; l < height; l++) {
+						for (int k = 0; k < width; k++) {
+							mask[i + k + (j + l) * uSize] = 0;
+						}
+					}
+
+					// emit the quad, stretching the single face data over the merged area
+					int pos[3];
+					pos[u] = i;
+					pos[v] = j;
+					pos[n] = slice;
+					pos[1] += y0;
+					BlockFace texture = { ((key - 1) & 0xFF) % ATLAS_SIZE, ((key - 1) & 0xFF) / ATLAS_SIZE };
+
+					glm::vec3 quadPos[4];
+					glm::vec2 quadUV[4];
+					int quadAO[4];
+					for (int k = 0; k < 4; k++) {
+						const float *corner = &faceQuadData[face][k * 5];
+						glm::vec3 vert = glm::vec3(corner[0], corner[1], corner[2]);
+						quadPos[k][n] = vert[n] + pos[n];
+						quadPos[k][u] = (vert[u] < 0.0f) ? pos[u] - 0.5f : pos[u] + width - 0.5f;
+						quadPos[k][v] = (vert[v] < 0.0f) ? pos[v] - 0.5f : pos[v] + height - 0.5f;
+
+						quadUV[k] = glm::vec2(corner[3] * width, corner[4] * height);
+						quadAO[k] = (ao >> (greedyCorner(face, vert) * 2)) & 3;
+					}
+					pushQuad(data, quadPos, quadUV, texture, face, quadAO);
+
+					i += width;
+				}
+			}
+		}
+	}
+}
+
+MeshBuilder::~MeshBuilder() {
+	delete snapshot;
+}
+
+const ChunkMesh *MeshBuilder::build(const ChunkSnapshot *snapshot) {
+	PROFILE_ZONE("buildMesh");
+
+	mesh.chunk = snapshot->chunk;
+	mesh.sectionMask = snapshot->sectionMask;
+	mesh.data.clear(); // keeps its capacity
+
+	/* DATA IS: packed vertices of CHUNK_VERTEX_SIZE unsigned ints, section after section */
+	for (int i = 0; i < N_SECTIONS; i++) {
+		mesh.sectionStart[i] = mesh.data.size() / CHUNK_VERTEX_SIZE;
+
+		if (!(snapshot->sectionMask & (1 << i))) {
+			continue;
+		}
+		mesh.revision[i] = snapshot->revision[i];
+
+		// hidden sections get an empty mesh
+		if (snapshot->hidden[i]) {
+			continue;
+		}
+
+		int y0 = i * SECTION_HEIGHT;
+		int y1 = y0 + Chunk::getSectionHeight(i);
+		if (snapshot->meshingMode == MESHING_GREEDY) {
+			buildGreedyMesh(snapshot, y0, y1, &mesh.data);
+		}
+		else {
+			buildNaiveMesh(snapshot, y0, y1, &mesh.data);
+		}
+	}
+	mesh.sectionStart[N_SECTIONS] = mesh.data.size() / CHUNK_VERTEX_SIZE;
+
+	return &mesh;
+}
+
+ChunkMesh *MeshBuilder::buildCopy(const ChunkSnapshot *snapshot) {
+	return new ChunkMesh(*build(snapshot));
+}
+
+ChunkSnapshot *MeshBuilder::getSnapshot() {
+	if (snapshot == NULL) {
+		snapshot = new ChunkSnapshot;
+	}
+	return snapshot;
+}
+
+MeshBuilder *MeshBuilder::getThreadBuilder() {
+	thread_local MeshBuilder builder;
+	return &builder;
+}
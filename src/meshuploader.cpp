@@ -0,0 +1,58 @@
+#include "meshuploader.h"
+#include "chunk.h"
+
+void MeshUploader::init() {
+	arena.init();
+}
+
+void MeshUploader::upload(const ChunkMesh *mesh, bool edited) {
+
+	Chunk *chunk = mesh->chunk;
+	for (int i = 0; i < N_SECTIONS; i++) {
+		if ((mesh->sectionMask & (1 << i)) && mesh->revision[i] == chunk->sections[i].meshRevision) {
+			uploadSection(&chunk->sections[i], mesh->getSection(i), mesh->getSectionVertices(i), edited);
+		}
+	}
+
+	chunk->isBuilt = true;
+}
+
+void MeshUploader::release(Chunk *chunk) {
+	for (int i = 0; i < N_SECTIONS; i++) {
+		freeSection(&chunk->sections[i]);
+	}
+}
+
+void MeshUploader::uploadSection(ChunkSection *section, const unsigned int *data, int n_vertices, bool edited) {
+
+	if (n_vertices > 0) {
+		arena.reserveQuadIndices(n_vertices / 4);
+	}
+
+	// the new mesh fits in the vertices already allocated: overwrite them
+	// (unless it would only use a small part of them)
+	if (n_vertices > 0 && n_vertices <= section->meshSize && n_vertices * 2 >= section->meshSize) {
+		section->n_meshVertices = n_vertices;
+		arena.upload(section->meshOffset, data, n_vertices);
+		return;
+	}
+
+	freeSection(section);
+
+	section->n_meshVertices = n_vertices;
+	if (n_vertices > 0) {
+		int size = edited ? n_vertices + n_vertices / MESH_EDIT_SLACK : n_vertices;
+		section->meshOffset = arena.allocate(size);
+		section->meshSize = MeshArena::getAllocatedSize(size); // the rounding is usable too
+		arena.upload(section->meshOffset, data, n_vertices);
+	}
+}
+
+// gives the section mesh's vertices back to the arena
+void MeshUploader::freeSection(ChunkSection *section) {
+	if (section->meshSize > 0) {
+		arena.release(section->meshOffset, section->meshSize);
+		section->meshSize = 0;
+	}
+	section->n_meshVertices = 0;
+}
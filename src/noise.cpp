@@ -0,0 +1,109 @@
+#include "noise.h"
+
+#include <cstring>
+
+// tile position of a chunk (rounded down for negative positions)
+static int getTileCoord(int chunkCoord) {
+	return chunkCoord >= 0 ? chunkCoord / NOISE_TILE_CHUNKS : (chunkCoord + 1) / NOISE_TILE_CHUNKS - 1;
+}
+
+void NoiseGenerator::init(int seed) {
+
+	// frequency, scale and seed offset of each layer (see NoiseLayerType)
+	float settings[N_NOISE_LAYERS][3] = {
+		{ 0.02f, 0.8f, 0 },
+		{ 0.005f, 0.3f, 1820 },
+		{ 0.02f, 0.3f, 2067 },
+		{ 0.01f, 0.5f, 920 }
+	};
+
+	for (int i = 0; i < N_NOISE_LAYERS; i++) {
+		auto simplex = FastNoise::New<FastNoise::Simplex>();
+		auto fractal = FastNoise::New<FastNoise::FractalFBm>();
+		auto scale = FastNoise::New<FastNoise::DomainScale>();
+
+		fractal->SetSource(simplex);
+		fractal->SetOctaveCount(4);
+		fractal->SetLacunarity(1.3f);
+		fractal->SetGain(0.9f);
+		fractal->SetWeightedStrength(0.5f);
+
+		scale->SetSource(fractal);
+		scale->SetScale(settings[i][1]);
+
+		layers[i].frequency = settings[i][0];
+		layers[i].scale = settings[i][1];
+		layers[i].seed = seed + static_cast<int>(settings[i][2]);
+		layers[i].node = scale;
+	}
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	tiles.clear();
+}
+
+void NoiseGenerator::getChunkNoise(int chunkX, int chunkZ, ChunkNoise *out) {
+
+	int tileX = getTileCoord(chunkX);
+	int tileZ = getTileCoord(chunkZ);
+
+	std::shared_ptr<NoiseTile> tile = getTile(tileX, tileZ);
+	std::call_once(tile->generated, [this, &tile]() {
+		generateTile(tile.get());
+	});
+
+	// rows of the chunk inside the tile
+	int x0 = (chunkX - tileX * NOISE_TILE_CHUNKS) * CHUNK_SIZE;
+	int z0 = (chunkZ - tileZ * NOISE_TILE_CHUNKS) * CHUNK_SIZE;
+	for (int i = 0; i < N_NOISE_LAYERS; i++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			memcpy(&out->layers[i][z * CHUNK_SIZE], &tile->layers[i][(z0 + z) * NOISE_TILE_SIZE + x0], CHUNK_SIZE * sizeof(float));
+		}
+	}
+}
+
+void NoiseGenerator::generateGrid(int layer, int xStart, int zStart, int xSize, int zSize, int step, float *out) {
+	// (xStart / step + i) * (frequency * step) is the position of the block xStart + i * step
+	layers[layer].node->GenUniformGrid2D(out, xStart / step, zStart / step, xSize, zSize,
+		layers[layer].frequency * step, layers[layer].seed);
+}
+
+std::shared_ptr<NoiseTile> NoiseGenerator::getTile(int tileX, int tileZ) {
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	useCounter++;
+
+	for (int i = 0; i < tiles.size(); i++) {
+		if (tiles[i]->x == tileX && tiles[i]->z == tileZ) {
+			tiles[i]->lastUsed = useCounter;
+			return tiles[i];
+		}
+	}
+
+	// drop the least recently used tile
+	if (tiles.size() >= NOISE_CACHE_TILES) {
+		int oldest = 0;
+		for (int i = 1; i < tiles.size(); i++) {
+			if (tiles[i]->lastUsed < tiles[oldest]->lastUsed) {
+				oldest = i;
+			}
+		}
+		tiles.erase(tiles.begin() + oldest);
+	}
+
+	std::shared_ptr<NoiseTile> tile = std::make_shared<NoiseTile>();
+	tile->x = tileX;
+	tile->z = tileZ;
+	tile->lastUsed = useCounter;
+	tiles.push_back(tile);
+	return tile;
+}
+
+void NoiseGenerator::generateTile(NoiseTile *tile) {
+	// same sample positions as one 16x16 grid per chunk: the terrain doesn't change
+	for (int i = 0; i < N_NOISE_LAYERS; i++) {
+		layers[i].node->GenUniformGrid2D(tile->layers[i],
+			tile->x * NOISE_TILE_SIZE, tile->z * NOISE_TILE_SIZE,
+			NOISE_TILE_SIZE, NOISE_TILE_SIZE,
+			layers[i].frequency, layers[i].seed);
+	}
+}
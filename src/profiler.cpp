@@ -0,0 +1,141 @@
+#include "profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// rings of all the threads that recorded a zone, never freed (the trace can be exported after a thread ends)
+static std::mutex ringsMutex;
+static std::vector<ProfileRing*> rings;
+
+static thread_local ProfileRing *threadRing = NULL;
+
+// frames, main thread only
+static float frameTimes[PROFILER_FRAMES]; // milliseconds, circular
+static int n_frames = 0; // frames ended so far
+static int64_t frameStart = -1;
+
+int64_t Profiler::getTime() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+ProfileRing *Profiler::getThreadRing() {
+
+	if (threadRing == NULL) {
+		threadRing = new ProfileRing;
+
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		threadRing->threadId = rings.size();
+		rings.push_back(threadRing);
+	}
+	return threadRing;
+}
+
+void Profiler::record(const char *name, int64_t start, int64_t end) {
+
+	ProfileRing *ring = getThreadRing();
+	uint64_t n = ring->n_events.load(std::memory_order_relaxed);
+
+	ProfileEvent *event = &ring->events[n % PROFILER_RING_SIZE];
+	event->name = name;
+	event->start = start;
+	event->end = end;
+
+	// the event is written before it is counted (see exportTrace)
+	ring->n_events.store(n + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const char *name) {
+	getThreadRing()->threadName = name;
+}
+
+void Profiler::beginFrame() {
+
+	int64_t now = getTime();
+	if (frameStart >= 0) {
+		frameTimes[n_frames % PROFILER_FRAMES] = (now - frameStart) / 1000000.0f;
+		n_frames++;
+		if (enabled.load(std::memory_order_relaxed)) {
+			record("frame", frameStart, now);
+		}
+	}
+	frameStart = now;
+}
+
+int Profiler::getFrameTimes(float *times, int count) {
+
+	int n = std::min(count, std::min(n_frames, PROFILER_FRAMES));
+	for (int i = 0; i < n; i++) {
+		times[i] = frameTimes[(n_frames - n + i) % PROFILER_FRAMES];
+	}
+	return n;
+}
+
+void Profiler::getFrameStats(float *average, float *maximum) {
+
+	int n = std::min(n_frames, PROFILER_FRAMES);
+	float total = 0.0f;
+	*maximum = 0.0f;
+	for (int i = 0; i < n; i++) {
+		total += frameTimes[i];
+		*maximum = std::max(*maximum, frameTimes[i]);
+	}
+	*average = n > 0 ? total / n : 0.0f;
+}
+
+int Profiler::exportTrace(const char *path) {
+
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		std::cout << "Error Profiler::exportTrace(): could not create " << path << "\n";
+		return 0;
+	}
+
+	std::vector<ProfileRing*> threads;
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		threads = rings;
+	}
+
+	std::vector<ProfileEvent> events;
+	int n_written = 0;
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (int i = 0; i < threads.size(); i++) {
+		ProfileRing *ring = threads[i];
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+			i == 0 ? "" : ",\n", ring->threadId, ring->threadName.load(), ring->threadId);
+
+		// only the counted events are complete
+		uint64_t n = ring->n_events.load(std::memory_order_acquire);
+		uint64_t copied = n > PROFILER_RING_SIZE ? n - PROFILER_RING_SIZE : 0;
+		events.resize(n - copied);
+		for (uint64_t j = copied; j < n; j++) {
+			events[j - copied] = ring->events[j % PROFILER_RING_SIZE];
+		}
+
+		// the thread kept recording during the copy: drop the slots it may have overwritten,
+		// including the one of the event it is writing now (n_after, not counted yet)
+		uint64_t n_after = ring->n_events.load(std::memory_order_acquire);
+		uint64_t first = copied;
+		if (n_after >= PROFILER_RING_SIZE && n_after - PROFILER_RING_SIZE + 1 > first) {
+			first = std::min(n, n_after - PROFILER_RING_SIZE + 1);
+		}
+
+		for (uint64_t j = first; j < n; j++) {
+			ProfileEvent event = events[j - copied];
+			// chrome traces are in microseconds
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				event.name, ring->threadId, event.start / 1000.0, (event.end - event.start) / 1000.0);
+			n_written++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	return n_written;
+}
@@ -1,17 +1,11 @@
 #include "raycast.h"
 #include "chunk.h"
 #include "block.h"
+#include "profiler.h"
+#include "gpustats.h"
 
 int Raycast::raycast(GLFWwindow *window, World *world, Camera *camera) {
-	glm::vec3 cameraPos = camera->Position;
-	Chunk *currentChunk = world->chunkManager.getPlayerChunk(camera);
-	glm::vec3 dir = glm::normalize(camera->Front);
-
-	glm::ivec3 blockPos = glm::ivec3(
-		floor(cameraPos.x) - currentChunk->position.x * CHUNK_SIZE,
-		floor(cameraPos.y),
-		floor(cameraPos.z) - currentChunk->position.y * CHUNK_SIZE);
-	glm::ivec3 prevBlockPos = glm::ivec3(0);
+	PROFILE_ZONE("raycast");
 
 	// debug current chunk
 	/*
@@ -23,63 +17,15 @@ int Raycast::raycast(GLFWwindow *window, World *world, Camera *camera) {
 
 	shader.setVec3("color", glm::vec3(0.0, 0.0, 0.0));
 
-	int dist = 0;
-	int maxDist = 90;
-	// while distance is respected and current block isn't solid
-	while (dist < maxDist
-		&& !currentChunk->isSolid(currentChunk->getBlock(blockPos.x, blockPos.y, blockPos.z))) {
-
-		cameraPos += dir * 0.05f;
-
-		prevBlockPos = glm::ivec3(blockPos.x, blockPos.y, blockPos.z);
-
-		blockPos = glm::ivec3(
-			floor(cameraPos.x) - currentChunk->position.x * CHUNK_SIZE,
-			floor(cameraPos.y),
-			floor(cameraPos.z) - currentChunk->position.y * CHUNK_SIZE);
-
-		// change chunks if the ray is out of the current chunk's bounds
-		if (currentChunk != NULL && blockPos.x > CHUNK_SIZE - 1) {
-			currentChunk = currentChunk->neighbors[NEIGHBOR_RIGHT];
-			blockPos.x = blockPos.x - CHUNK_SIZE;
-		}
-		if (currentChunk != NULL && blockPos.x < 0) {
-			currentChunk = currentChunk->neighbors[NEIGHBOR_LEFT];
-			blockPos.x = blockPos.x + CHUNK_SIZE;
-		}
-		if (currentChunk != NULL && blockPos.z > CHUNK_SIZE - 1) {
-			currentChunk = currentChunk->neighbors[NEIGHBOR_UP];
-			blockPos.z = blockPos.z - CHUNK_SIZE;
-		}
-		if (currentChunk != NULL && blockPos.z < 0) {
-			currentChunk = currentChunk->neighbors[NEIGHBOR_DOWN];
-			blockPos.z = blockPos.z + CHUNK_SIZE;
-		}
-
-		dist++;
-
-	}
-
-
-	// returns
-	if (currentChunk->isSolid(currentChunk->getBlock(blockPos.x, blockPos.y, blockPos.z))) {
+	RayHit hit;
+	if (traceRay(&world->chunkManager, camera->Position, camera->Front, reach, &hit)) {
 		// render the block wireframe
-		renderBlock(
-			glm::vec3(blockPos.x + currentChunk->position.x * CHUNK_SIZE,
-				blockPos.y,
-				blockPos.z + currentChunk->position.y * CHUNK_SIZE),
-			glm::vec3(1, 1, 1));
+		renderBlock(glm::vec3(hit.worldPos), glm::vec3(1, 1, 1));
 
 		// set hit block data
-		hitBlockPos = blockPos;
-		hitChunk = currentChunk;
-
-		// calculate the face that was hit
-		int off_x, off_y, off_z;
-		off_x = blockPos.x - prevBlockPos.x;
-		off_y = blockPos.y - prevBlockPos.y;
-		off_z = blockPos.z - prevBlockPos.z;
-		hitFace = glm::ivec3(-off_x, -off_y, -off_z);
+		hitBlockPos = hit.blockPos;
+		hitChunk = hit.chunk;
+		hitFace = hit.face;
 
 		return 1;
 	}
@@ -102,6 +48,7 @@ void Raycast::renderBlock(glm::vec3 pos, glm::vec3 scale) {
 	glBindVertexArray(VAO);
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 	glDrawArrays(GL_TRIANGLES, 0, 36);
+	GpuStats::addDraw(36);
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
 
@@ -0,0 +1,139 @@
+#include "rayquery.h"
+#include "chunk.h"
+#include "chunkmanager.h"
+
+#include <cmath>
+
+// a ray between two blocks
+struct RayWalk {
+	int pos[3]; // current block (world coordinates)
+	int step[3]; // -1, 0 or 1 on each axis
+	float delta[3]; // distance along the ray between two block borders of the axis
+	float tMax[3]; // distance along the ray to the next block border of the axis
+};
+
+// chunk coordinate of a block coordinate (rounds towards negative infinity)
+static inline int getChunkCoordinate(int block) {
+	return (block - (block < 0 ? CHUNK_SIZE - 1 : 0)) / CHUNK_SIZE;
+}
+
+// returns 0 if the direction is null
+static int startRayWalk(glm::vec3 origin, glm::vec3 dir, RayWalk *walk) {
+
+	float length = glm::length(dir);
+	if (length == 0.0f) {
+		return 0;
+	}
+	dir = dir * (1.0f / length);
+
+	// block x spans [x - 0.5, x + 0.5]: shifted by half a block, blocks are the integer cells
+	glm::vec3 start = origin + glm::vec3(0.5f);
+	float s[3] = { start.x, start.y, start.z };
+	float d[3] = { dir.x, dir.y, dir.z };
+
+	for (int i = 0; i < 3; i++) {
+		float cell = floor(s[i]);
+		float frac = s[i] - cell;
+		walk->pos[i] = (int)cell;
+		walk->step[i] = d[i] > 0 ? 1 : (d[i] < 0 ? -1 : 0);
+		walk->delta[i] = walk->step[i] != 0 ? fabs(1.0f / d[i]) : INFINITY;
+		walk->tMax[i] = walk->step[i] > 0 ? (1.0f - frac) * walk->delta[i]
+			: (walk->step[i] < 0 ? frac * walk->delta[i] : INFINITY);
+	}
+	return 1;
+}
+
+static void setHit(RayHit *hit, Chunk *chunk, int x, int y, int z, glm::ivec3 face, float t) {
+	hit->chunk = chunk;
+	hit->blockPos = glm::ivec3(x, y, z);
+	hit->worldPos = glm::ivec3(x + chunk->position.x * CHUNK_SIZE, y, z + chunk->position.y * CHUNK_SIZE);
+	hit->face = face;
+	hit->distance = t;
+}
+
+int traceRay(ChunkManager *chunkManager, glm::vec3 origin, glm::vec3 dir, float maxDistance, RayHit *hit) {
+
+	hit->chunk = NULL;
+
+	RayWalk walk;
+	if (!startRayWalk(origin, dir, &walk)) {
+		return 0;
+	}
+
+	int xChunk = getChunkCoordinate(walk.pos[0]);
+	int zChunk = getChunkCoordinate(walk.pos[2]);
+	Chunk *chunk = chunkManager->getLoadedChunk(xChunk, zChunk);
+
+	// x and z are in the current chunk
+	int x = walk.pos[0] - xChunk * CHUNK_SIZE;
+	int y = walk.pos[1];
+	int z = walk.pos[2] - zChunk * CHUNK_SIZE;
+
+	glm::ivec3 face = glm::ivec3(0);
+	float t = 0.0f;
+
+	while (true) {
+
+		// chunks being generated can't be read
+		if (chunk == NULL || !chunk->isGenerated) {
+			return 0;
+		}
+
+		if (chunk->isSolidBlock(x, y, z)) {
+			setHit(hit, chunk, x, y, z, face, t);
+			return 1;
+		}
+
+		// cross the closest block border
+		if (walk.tMax[0] < walk.tMax[1] && walk.tMax[0] < walk.tMax[2]) {
+			t = walk.tMax[0];
+			walk.tMax[0] += walk.delta[0];
+			x += walk.step[0];
+			face = glm::ivec3(-walk.step[0], 0, 0);
+			if (x < 0) {
+				chunk = chunk->neighbors[NEIGHBOR_LEFT];
+				x += CHUNK_SIZE;
+			}
+			else if (x >= CHUNK_SIZE) {
+				chunk = chunk->neighbors[NEIGHBOR_RIGHT];
+				x -= CHUNK_SIZE;
+			}
+		}
+		else if (walk.tMax[1] < walk.tMax[2]) {
+			t = walk.tMax[1];
+			walk.tMax[1] += walk.delta[1];
+			y += walk.step[1];
+			face = glm::ivec3(0, -walk.step[1], 0);
+			// nothing above or below the world
+			if ((y < 0 && walk.step[1] < 0) || (y >= HEIGHT_LIMIT && walk.step[1] > 0)) {
+				return 0;
+			}
+		}
+		else {
+			t = walk.tMax[2];
+			walk.tMax[2] += walk.delta[2];
+			z += walk.step[2];
+			face = glm::ivec3(0, 0, -walk.step[2]);
+			if (z < 0) {
+				chunk = chunk->neighbors[NEIGHBOR_DOWN];
+				z += CHUNK_SIZE;
+			}
+			else if (z >= CHUNK_SIZE) {
+				chunk = chunk->neighbors[NEIGHBOR_UP];
+				z -= CHUNK_SIZE;
+			}
+		}
+
+		if (t > maxDistance) {
+			return 0;
+		}
+	}
+}
+
+int traceRays(ChunkManager *chunkManager, const RayQuery *rays, int n, RayHit *hits) {
+	int n_hits = 0;
+	for (int i = 0; i < n; i++) {
+		n_hits += traceRay(chunkManager, rays[i].origin, rays[i].dir, rays[i].maxDistance, &hits[i]);
+	}
+	return n_hits;
+}
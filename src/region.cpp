@@ -0,0 +1,623 @@
+#include "region.h"
+#include "chunk.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// chunk position -> region position (rounded down for negative positions)
+static int getRegionCoord(int chunkCoord) {
+	return chunkCoord >= 0 ? chunkCoord / REGION_SIZE : (chunkCoord + 1) / REGION_SIZE - 1;
+}
+
+// index of a chunk inside its region file
+static int getRegionIndex(int x, int z) {
+	return (x - getRegionCoord(x) * REGION_SIZE) + (z - getRegionCoord(z) * REGION_SIZE) * REGION_SIZE;
+}
+
+static uint64_t getPositionKey(int x, int z) {
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
+
+// region files are little endian whatever the platform
+static void put32(unsigned char *p, uint32_t v) {
+	p[0] = v & 0xFF;
+	p[1] = (v >> 8) & 0xFF;
+	p[2] = (v >> 16) & 0xFF;
+	p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t get32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/* RegionFile */
+
+RegionFile::~RegionFile() {
+	close();
+}
+
+int RegionFile::open(const char *path, bool create) {
+
+	close();
+
+	this->path = path;
+	file = fopen(path, "r+b");
+	if (file == NULL) {
+		if (!create) {
+			return 0;
+		}
+		file = fopen(path, "w+b");
+		if (file == NULL) {
+			std::cout << "Error RegionFile::open(): could not create " << path << "\n";
+			return 0;
+		}
+	}
+
+	memset(locations, 0, sizeof(locations));
+	usedSectors.assign(REGION_HEADER_SECTORS, 1);
+
+	fseek(file, 0, SEEK_END);
+	long fileSize = ftell(file);
+
+	if (fileSize < REGION_HEADER_SECTORS * REGION_SECTOR_SIZE) {
+		// new (or truncated before its header was written): start with an empty location table
+		if (!writeHeader() || !sync() || !updateMapping()) {
+			close();
+			return 0;
+		}
+		return 1;
+	}
+
+	unsigned char header[REGION_CHUNKS * 4];
+	fseek(file, 0, SEEK_SET);
+	if (fread(header, 1, sizeof(header), file) != sizeof(header)) {
+		close();
+		return 0;
+	}
+
+	// rebuild the sector map from the location table
+	int n_sectors = static_cast<int>(fileSize / REGION_SECTOR_SIZE);
+	usedSectors.resize(n_sectors, 0);
+	for (int i = 0; i < REGION_CHUNKS; i++) {
+		uint32_t location = get32(&header[i * 4]);
+		int first = location >> 8;
+		int count = location & 0xFF;
+		// a location pointing outside of the file can only come from a corrupted header: forget the chunk
+		if (location == 0 || first < REGION_HEADER_SECTORS || first + count > n_sectors) {
+			continue;
+		}
+		locations[i] = location;
+		for (int j = first; j < first + count; j++) {
+			usedSectors[j] = 1;
+		}
+	}
+
+	if (!updateMapping()) {
+		close();
+		return 0;
+	}
+
+	return 1;
+}
+
+void RegionFile::close() {
+	mapping.unmap();
+	if (file != NULL) {
+		fclose(file);
+		file = NULL;
+	}
+}
+
+const unsigned char *RegionFile::getChunkData(int index, int *length) {
+
+	if (file == NULL || locations[index] == 0) {
+		return NULL;
+	}
+
+	size_t first = (size_t)(locations[index] >> 8) * REGION_SECTOR_SIZE;
+	size_t size = (size_t)(locations[index] & 0xFF) * REGION_SECTOR_SIZE;
+	if (first + size > mapping.getSize()) {
+		return NULL;
+	}
+
+	const unsigned char *data = mapping.getData() + first;
+	uint32_t dataLength = get32(data);
+	if (data[4] != REGION_COMPRESSION_RLE || dataLength + 5 > size) {
+		std::cout << "Error RegionFile::getChunkData(): invalid chunk header\n";
+		return NULL;
+	}
+
+	*length = static_cast<int>(dataLength);
+	return data + 5;
+}
+
+void RegionFile::prefetchChunk(int index) {
+	if (locations[index] != 0) {
+		mapping.prefetch((size_t)(locations[index] >> 8) * REGION_SECTOR_SIZE, (size_t)(locations[index] & 0xFF) * REGION_SECTOR_SIZE);
+	}
+}
+
+int RegionFile::updateMapping() {
+
+	// the file always ends on the last allocated sector
+	if (mapping.getData() != NULL && mapping.getSize() >= usedSectors.size() * REGION_SECTOR_SIZE) {
+		return 1;
+	}
+	return mapping.map(path.c_str());
+}
+
+int RegionFile::writeChunks(const int *indices, const std::vector<unsigned char> *const *data, int n, int *written) {
+
+	for (int i = 0; i < n; i++) {
+		written[i] = 0;
+	}
+	if (file == NULL) {
+		return 0;
+	}
+
+	std::vector<uint32_t> newLocations(n);
+
+	// 1: write every chunk to free sectors (the current versions stay untouched)
+	std::vector<unsigned char> buffer;
+	for (int i = 0; i < n; i++) {
+		int length = static_cast<int>(data[i]->size());
+		int count = (length + 5 + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+		if (count > REGION_MAX_CHUNK_SECTORS) {
+			std::cout << "Error RegionFile::writeChunks(): chunk too big (" << length << " bytes)\n";
+			continue;
+		}
+
+		// padded to whole sectors so that the file always ends on a sector
+		buffer.assign((size_t)count * REGION_SECTOR_SIZE, 0);
+		put32(buffer.data(), length);
+		buffer[4] = REGION_COMPRESSION_RLE;
+		memcpy(buffer.data() + 5, data[i]->data(), length);
+
+		int first = allocateSectors(count);
+		if (fseek(file, (long)first * REGION_SECTOR_SIZE, SEEK_SET) != 0 || fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+			std::cout << "Error RegionFile::writeChunks(): could not write chunk " << indices[i] << " of " << path << "\n";
+			freeSectors(first, count);
+			continue;
+		}
+		newLocations[i] = (first << 8) | count;
+	}
+
+	if (!sync()) {
+		return 0;
+	}
+
+	// 2: point the location table to the new versions
+	std::vector<uint32_t> oldLocations(n);
+	for (int i = 0; i < n; i++) {
+		oldLocations[i] = locations[indices[i]];
+		if (newLocations[i] != 0) {
+			locations[indices[i]] = newLocations[i];
+		}
+	}
+
+	if (!writeHeader() || !sync()) {
+		return 0;
+	}
+
+	// 3: the old versions can now be overwritten
+	int n_written = 0;
+	for (int i = 0; i < n; i++) {
+		if (newLocations[i] != 0 && oldLocations[i] != 0) {
+			freeSectors(oldLocations[i] >> 8, oldLocations[i] & 0xFF);
+		}
+		written[i] = newLocations[i] != 0;
+		n_written += written[i];
+	}
+
+	// the new chunks can be past the end of the mapping
+	if (!updateMapping()) {
+		return 0;
+	}
+	return n_written;
+}
+
+int RegionFile::allocateSectors(int n) {
+
+	int size = static_cast<int>(usedSectors.size());
+
+	// first fit
+	int run = 0;
+	for (int i = REGION_HEADER_SECTORS; i < size; i++) {
+		run = usedSectors[i] ? 0 : run + 1;
+		if (run == n) {
+			int first = i - n + 1;
+			memset(&usedSectors[first], 1, n);
+			return first;
+		}
+	}
+
+	// append (reusing the free sectors at the end of the file)
+	int first = size - run;
+	usedSectors.resize(first + n, 1);
+	memset(&usedSectors[first], 1, n);
+	return first;
+}
+
+void RegionFile::freeSectors(int first, int n) {
+	memset(&usedSectors[first], 0, n);
+}
+
+int RegionFile::writeHeader() {
+
+	unsigned char header[REGION_HEADER_SECTORS * REGION_SECTOR_SIZE] = { 0 };
+	for (int i = 0; i < REGION_CHUNKS; i++) {
+		put32(&header[i * 4], locations[i]);
+	}
+
+	// a single sector write: the table is never left half old, half new
+	fseek(file, 0, SEEK_SET);
+	return fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+int RegionFile::sync() {
+
+	if (fflush(file) != 0) {
+		return 0;
+	}
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+/* RegionStore */
+
+RegionStore::~RegionStore() {
+	for (auto& region : regions) {
+		delete region.second;
+	}
+}
+
+void RegionStore::init(const char *directory) {
+
+	this->directory = directory;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) {
+		std::cout << "Error RegionStore::init(): could not create " << directory << "\n";
+	}
+}
+
+void RegionStore::saveChunk(Chunk *chunk) {
+
+	std::vector<unsigned char> data;
+	encodeChunk(chunk, &data);
+
+	std::lock_guard<std::mutex> lock(regionsMutex);
+	PendingChunk *pending = &pendingChunks[getPositionKey(chunk->position.x, chunk->position.y)];
+	pending->data.swap(data);
+	pending->revision = ++revision;
+}
+
+int RegionStore::loadChunk(Chunk *chunk) {
+
+	int x = chunk->position.x;
+	int z = chunk->position.y;
+
+	auto start = std::chrono::steady_clock::now();
+
+	int decoded;
+	RegionFile *region;
+	{
+		std::lock_guard<std::mutex> lock(regionsMutex);
+
+		// saved but not written yet
+		auto pending = pendingChunks.find(getPositionKey(x, z));
+		if (pending != pendingChunks.end()) {
+			region = NULL;
+			decoded = decodeChunk(pending->second.data.data(), static_cast<int>(pending->second.data.size()), chunk);
+		}
+		else {
+			region = getRegion(getRegionCoord(x), getRegionCoord(z), false);
+			if (region == NULL) {
+				return 0;
+			}
+		}
+	}
+
+	if (region != NULL) {
+		// decoded straight from the mapping: several chunks of the same region can be read at once
+		std::shared_lock<std::shared_mutex> lock(region->mutex);
+		int length;
+		const unsigned char *data = region->getChunkData(getRegionIndex(x, z), &length);
+		if (data == NULL) {
+			return 0;
+		}
+		decoded = decodeChunk(data, length, chunk);
+	}
+
+	if (!decoded) {
+		std::cout << "Error RegionStore::loadChunk(): invalid data for chunk " << x << ", " << z << "\n";
+		// a worker thread: the chunk's flags and neighbors are left to the main thread
+		chunk->clearBlocks();
+		return 0;
+	}
+
+	float time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::lock_guard<std::mutex> lock(statsMutex);
+	loadTimes.push_back(time);
+
+	return 1;
+}
+
+void RegionStore::prefetchChunks(int x0, int z0, int x1, int z1) {
+
+	std::vector<std::pair<RegionFile*, int>> chunks;
+	{
+		std::lock_guard<std::mutex> lock(regionsMutex);
+		for (int x = x0; x <= x1; x++) {
+			for (int z = z0; z <= z1; z++) {
+				RegionFile *region = getRegion(getRegionCoord(x), getRegionCoord(z), false);
+				if (region != NULL) {
+					chunks.push_back(std::make_pair(region, getRegionIndex(x, z)));
+				}
+			}
+		}
+	}
+
+	// only a hint: a region being flushed is not waited for
+	for (int i = 0; i < chunks.size(); i++) {
+		std::shared_lock<std::shared_mutex> regionLock(chunks[i].first->mutex, std::try_to_lock);
+		if (regionLock.owns_lock()) {
+			chunks[i].first->prefetchChunk(chunks[i].second);
+		}
+	}
+}
+
+void RegionStore::flush() {
+
+	std::lock_guard<std::mutex> flushLock(flushMutex);
+
+	// copy the pending chunks: they stay readable by loadChunk until they are written
+	std::unordered_map<uint64_t, std::vector<std::pair<uint64_t, PendingChunk>>> byRegion;
+	{
+		std::lock_guard<std::mutex> lock(regionsMutex);
+		for (auto& pending : pendingChunks) {
+			int x = static_cast<int>(pending.first >> 32);
+			int z = static_cast<int>(pending.first & 0xFFFFFFFF);
+			byRegion[getPositionKey(getRegionCoord(x), getRegionCoord(z))].push_back(pending);
+		}
+	}
+
+	for (auto& chunks : byRegion) {
+		int regionX = static_cast<int>(chunks.first >> 32);
+		int regionZ = static_cast<int>(chunks.first & 0xFFFFFFFF);
+
+		RegionFile *region;
+		{
+			std::lock_guard<std::mutex> lock(regionsMutex);
+			region = getRegion(regionX, regionZ, true);
+		}
+		if (region == NULL) {
+			continue;
+		}
+
+		int n = static_cast<int>(chunks.second.size());
+		std::vector<int> indices(n);
+		std::vector<const std::vector<unsigned char>*> data(n);
+		for (int i = 0; i < n; i++) {
+			uint64_t key = chunks.second[i].first;
+			indices[i] = getRegionIndex(static_cast<int>(key >> 32), static_cast<int>(key & 0xFFFFFFFF));
+			data[i] = &chunks.second[i].second.data;
+		}
+
+		int n_written;
+		std::vector<int> written(n);
+		{
+			std::unique_lock<std::shared_mutex> lock(region->mutex);
+			n_written = region->writeChunks(indices.data(), data.data(), n, written.data());
+		}
+		if (n_written < n) {
+			// kept pending, retried at the next flush
+			std::cout << "Error RegionStore::flush(): could not write " << n - n_written << " of " << n << " chunks to region " << regionX << ", " << regionZ << "\n";
+		}
+
+		// chunks saved again during the write are kept for the next flush
+		std::lock_guard<std::mutex> lock(regionsMutex);
+		for (int i = 0; i < n; i++) {
+			if (!written[i]) {
+				continue;
+			}
+			auto pending = pendingChunks.find(chunks.second[i].first);
+			if (pending != pendingChunks.end() && pending->second.revision == chunks.second[i].second.revision) {
+				pendingChunks.erase(pending);
+			}
+		}
+	}
+}
+
+bool RegionStore::hasPendingChunks() {
+	std::lock_guard<std::mutex> lock(regionsMutex);
+	return !pendingChunks.empty();
+}
+
+void RegionStore::printLoadStats() {
+
+	std::vector<float> times;
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		times.swap(loadTimes);
+	}
+	if (times.size() == 0) {
+		return;
+	}
+
+	std::sort(times.begin(), times.end());
+	float total = 0.0f;
+	for (int i = 0; i < times.size(); i++) {
+		total += times[i];
+	}
+
+	std::cout << "region loads: " << times.size() << " chunks | "
+		<< "avg " << total / times.size() << " ms | "
+		<< "p50 " << times[times.size() / 2] << " ms | "
+		<< "p95 " << times[times.size() * 95 / 100] << " ms | "
+		<< "max " << times.back() << " ms\n";
+}
+
+RegionFile *RegionStore::getRegion(int regionX, int regionZ, bool create) {
+
+	RegionFile *&region = regions[getPositionKey(regionX, regionZ)];
+	if (region == NULL) {
+		region = new RegionFile;
+	}
+
+	// region files are only created by this store: a missing one is not looked for again until it is
+	if (!region->isOpen() && (create || !region->missing)) {
+		std::string path = directory + "/r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".kr";
+		std::unique_lock<std::shared_mutex> lock(region->mutex);
+		region->missing = !region->open(path.c_str(), create);
+	}
+
+	return region->isOpen() ? region : NULL;
+}
+
+int RegionStore::readWorldInfo(int *seed) {
+
+	FILE *file = fopen((directory + "/world.txt").c_str(), "r");
+	if (file == NULL) {
+		return 0;
+	}
+	int read = fscanf(file, "seed %d", seed) == 1;
+	fclose(file);
+	return read;
+}
+
+void RegionStore::writeWorldInfo(int seed) {
+
+	FILE *file = fopen((directory + "/world.txt").c_str(), "w");
+	if (file == NULL) {
+		std::cout << "Error RegionStore::writeWorldInfo(): could not write the world info\n";
+		return;
+	}
+	fprintf(file, "seed %d\n", seed);
+	fclose(file);
+}
+
+/* chunk encoding */
+
+// [version][CHUNK_SIZE][SECTION_HEIGHT][N_SECTIONS] then runs of [length (varint)][block]
+// covering every section from the bottom, each in SECTION_INDEX order (so a section decodes with memsets)
+#define CHUNK_DATA_HEADER 4
+
+static void putRun(std::vector<unsigned char> *out, unsigned int run, Block block) {
+	while (run >= 0x80) {
+		out->push_back((run & 0x7F) | 0x80);
+		run >>= 7;
+	}
+	out->push_back(run);
+	out->push_back(block);
+}
+
+void encodeChunk(Chunk *chunk, std::vector<unsigned char> *out) {
+
+	out->clear();
+	out->push_back(REGION_FORMAT_VERSION);
+	out->push_back(CHUNK_SIZE);
+	out->push_back(SECTION_HEIGHT);
+	out->push_back(N_SECTIONS);
+
+	Block blocks[STORAGE_SIZE];
+	Block current = BlockType::AIR;
+	unsigned int run = 0;
+
+	for (int s = 0; s < N_SECTIONS; s++) {
+		const BlockStorage *storage = &chunk->sections[s].blocks;
+
+		// single block type: no need to look at each block
+		if (storage->getBits() == 0) {
+			Block block = storage->get(0);
+			if (run > 0 && block != current) {
+				putRun(out, run, current);
+				run = 0;
+			}
+			current = block;
+			run += STORAGE_SIZE;
+			continue;
+		}
+
+		storage->getRow(0, STORAGE_SIZE, blocks);
+		for (int i = 0; i < STORAGE_SIZE; i++) {
+			if (run > 0 && blocks[i] != current) {
+				putRun(out, run, current);
+				run = 0;
+			}
+			current = blocks[i];
+			run++;
+		}
+	}
+
+	putRun(out, run, current);
+}
+
+int decodeChunk(const unsigned char *data, int size, Chunk *chunk) {
+
+	if (size < CHUNK_DATA_HEADER || data[0] != REGION_FORMAT_VERSION || data[1] != CHUNK_SIZE
+		|| data[2] != SECTION_HEIGHT || data[3] != N_SECTIONS) {
+		return 0;
+	}
+
+	Block blocks[STORAGE_SIZE];
+	int section = 0;
+	int n = 0; // blocks of the current section decoded so far
+
+	int i = CHUNK_DATA_HEADER;
+	while (i < size) {
+
+		unsigned int run = 0;
+		int shift = 0;
+		while (i < size && (data[i] & 0x80) && shift < 28) {
+			run |= (data[i++] & 0x7F) << shift;
+			shift += 7;
+		}
+		if (i + 1 >= size || (run == 0 && data[i] == 0)) {
+			return 0;
+		}
+		run |= data[i++] << shift;
+		Block block = data[i++];
+		// an unknown type would be read past the texture tables when meshing
+		if (block > BlockType::MOON) {
+			return 0;
+		}
+
+		// a run can cover several sections
+		while (run > 0) {
+			if (section == N_SECTIONS) {
+				return 0;
+			}
+			int n_set = std::min(run, (unsigned int)(STORAGE_SIZE - n));
+			memset(blocks + n, block, n_set);
+			n += n_set;
+			run -= n_set;
+
+			if (n == STORAGE_SIZE) {
+				chunk->setSectionBlocks(section, blocks);
+				section++;
+				n = 0;
+			}
+		}
+	}
+
+	if (section != N_SECTIONS) {
+		return 0;
+	}
+
+	chunk->calculateHeightmap();
+	return 1;
+}
@@ -1,16 +1,21 @@
 #include "renderer.h"
+#include "gpustats.h"
 
 void prepareShaderMatrices(Shader* shader, Camera* camera) {
 
 	// set projection, view matrices
 	shader->use();
-	glm::mat4 projection = glm::perspective(glm::radians(camera->Zoom), (float)WIN_WIDTH / (float)WIN_HEIGHT, NEAR_PLANE, FAR_PLANE);
+	glm::mat4 projection = getProjectionMatrix(camera);
 	shader->setMat4("projection", projection);
 	glm::mat4 view = camera->GetViewMatrix();
 	shader->setMat4("view", view);
 
 }
 
+glm::mat4 getProjectionMatrix(Camera* camera) {
+	return glm::perspective(glm::radians(camera->Zoom), (float)WIN_WIDTH / (float)WIN_HEIGHT, NEAR_PLANE, FAR_PLANE);
+}
+
 void BlockModel::init() {
 
 	initBlockVAO();
@@ -91,4 +96,5 @@ void BlockModel::renderBlock(Shader *shader, glm::vec3 pos, glm::vec3 rot, glm::
 	glBindVertexArray(VAO);
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	glDrawArrays(GL_TRIANGLES, 0, 36);
+	GpuStats::addDraw(36);
 }
\ No newline at end of file
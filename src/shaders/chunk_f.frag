@@ -2,14 +2,19 @@
 out vec4 FragColor;
 
 in vec2 TexCoord;
+flat in vec2 TexOffset;
 in float AO;
 
 uniform sampler2D textures; // blocks textures
 uniform float sunLight;
 
+int n_textures = 6; // number of textures in a column/line in the atlas texture
+
 void main()
 {
-	vec4 texColor = texture(textures, TexCoord);
+	// repeat the block texture over the quad
+	vec2 tileCoord = (fract(TexCoord) + TexOffset) / n_textures;
+	vec4 texColor = texture(textures, tileCoord);
 
 	// texColor = vec4(1.0);
 
@@ -1,25 +1,36 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
-layout (location = 2) in vec2 aTexOffset;
-layout (location = 3) in float aAO;
+layout (location = 0) in uvec2 aData; // packed vertex, see CHUNK_VERTEX_SIZE in chunk.h
+layout (location = 1) in ivec2 aChunk; // chunk position (one per draw)
 
 out vec2 TexCoord;
+flat out vec2 TexOffset;
 out float AO;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
-int n_textures = 6; // number of textures in a column/line in the atlas texture
+uint n_textures = 6u; // number of textures in a column/line in the atlas texture
+int chunkSize = 16;
+
+// ambient occlusion value for each level (3 is unoccluded)
+const float aoValues[4] = float[4](0.7, 0.8, 0.9, 1.0);
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0f);
+	// positions are stored shifted by half a block so that they are positive integers
+	vec3 aPos = vec3(aData.x & 31u, (aData.x >> 5) & 511u, (aData.x >> 14) & 31u) - 0.5;
+	// uint face = (aData.x >> 19) & 7u; // not used yet
+	uint ao = (aData.x >> 22) & 3u;
+
+	uint tile = (aData.y >> 18) & 63u;
+
+	vec3 chunkOrigin = vec3(aChunk.x * chunkSize, 0, aChunk.y * chunkSize);
+	gl_Position = projection * view * vec4(aPos + chunkOrigin, 1.0f);
 
-	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
-	vec2 texOffset = vec2(aTexOffset.x, aTexOffset.y);
+	// texture coordinates go from 0 to the quad size for merged faces (greedy meshing)
+	// the texture is tiled once per block: the atlas offset is applied per fragment
+	TexCoord = vec2(aData.y & 511u, (aData.y >> 9) & 511u);
+	TexOffset = vec2(tile % n_textures, tile / n_textures);
 
-	TexCoord = (TexCoord + texOffset) / n_textures;
-	AO = aAO;
+	AO = aoValues[ao];
 }
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec2 aPos; // normalized device coordinates
+layout (location = 1) in vec3 aColor;
+
+out vec3 Color;
+
+void main()
+{
+	gl_Position = vec4(aPos, 0.0f, 1.0f);
+	Color = aColor;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Color;
+in vec2 WorldXZ;
+
+uniform float sunLight;
+uniform vec2 detailMin; // square drawn by the chunks
+uniform vec2 detailMax;
+
+void main()
+{
+	if (all(greaterThan(WorldXZ, detailMin)) && all(lessThan(WorldXZ, detailMax))) {
+		discard;
+	}
+
+	FragColor = vec4(Color * sunLight, 1.0);
+}
\ No newline at end of file
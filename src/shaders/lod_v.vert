@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos; // position in the tile (y is the height)
+layout (location = 1) in vec4 aColor; // shaded surface color
+
+out vec3 Color;
+out vec2 WorldXZ;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 tileOrigin;
+
+void main()
+{
+	vec3 worldPos = aPos + tileOrigin;
+	gl_Position = projection * view * vec4(worldPos, 1.0f);
+
+	Color = aColor.rgb;
+	WorldXZ = worldPos.xz;
+}
\ No newline at end of file
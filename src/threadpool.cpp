@@ -0,0 +1,83 @@
+#include "threadpool.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+// heap comparator: the job with the lowest priority value ends up on top
+static bool comparePoolJobs(const PoolJob& a, const PoolJob& b) {
+	return a.priority > b.priority;
+}
+
+ThreadPool::~ThreadPool() {
+	stop();
+}
+
+void ThreadPool::start(int n_threads) {
+
+	stopping = false;
+
+	for (int i = 0; i < n_threads; i++) {
+		threads.push_back(std::thread(&ThreadPool::workerLoop, this));
+	}
+}
+
+void ThreadPool::stop() {
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		jobs.clear();
+	}
+	condition.notify_all();
+
+	for (int i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	threads.clear();
+}
+
+void ThreadPool::submit(float priority, std::function<void()> job) {
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(PoolJob{ priority, std::move(job) });
+		std::push_heap(jobs.begin(), jobs.end(), comparePoolJobs);
+	}
+	condition.notify_one();
+}
+
+int ThreadPool::pendingJobs() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobs.size() + runningJobs;
+}
+
+void ThreadPool::workerLoop() {
+
+	Profiler::setThreadName("worker");
+
+	while (true) {
+
+		PoolJob job;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+			if (stopping) {
+				return;
+			}
+
+			std::pop_heap(jobs.begin(), jobs.end(), comparePoolJobs);
+			job = std::move(jobs.back());
+			jobs.pop_back();
+			runningJobs++;
+		}
+
+		job.run();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			runningJobs--;
+		}
+	}
+}
@@ -3,7 +3,7 @@
 void initGlfw() {
 
 	glfwInit(); // init GLFW
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); // configure GLFW
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4); // configure GLFW (4.3 for multi draw indirect)
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -13,6 +13,12 @@ GLFWwindow* openWindow() {
 
 	// create window
 	GLFWwindow* window = glfwCreateWindow(WIN_WIDTH, WIN_HEIGHT, "kraf", NULL, NULL);
+	if (window == NULL) {
+		// no OpenGL 4.3: chunks are then drawn one by one
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		window = glfwCreateWindow(WIN_WIDTH, WIN_HEIGHT, "kraf", NULL, NULL);
+	}
 	if (window == NULL) {
 		std::cout << "Failed to create GLFW window\n";
 		glfwTerminate();